@@ -0,0 +1,746 @@
+/*!
+ * @file
+ * @brief This file contains throughput benchmarks of Mealy machine.
+ * Every machine is measured with every transition chooser and in compiled
+ * form on self-generated corpus.
+ * Transitions are counted as consumed symbols plus EOF transitions.
+ *
+ * usage: MealyMachineBench [corpus size in MB] [repetitions]
+ */
+
+#include <MealyMachine/AhoCorasickBuilder.h>
+#include <MealyMachine/ArrayTransitionChooser.h>
+#include <MealyMachine/BasicMealyMachine.h>
+#include <MealyMachine/HashTransitionChooser.h>
+#include <MealyMachine/IntervalTransitionChooser.h>
+#include <MealyMachine/MapTransitionChooser.h>
+#include <MealyMachine/MealyMachine.h>
+#include <MealyMachine/Regex.h>
+#include <MealyMachine/ThreadPool.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <regex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace mealyMachine;
+
+namespace {
+
+using ChooserFactory = std::function<std::shared_ptr<TransitionChooser>()>;
+using MachineBuilder =
+    std::function<void(MealyMachine&, ChooserFactory const&)>;
+
+struct Variant {
+  std::string    name;
+  ChooserFactory chooser;
+  bool           compile;
+};
+
+struct Corpus {
+  std::string              stream;
+  std::vector<std::string> tokens;
+  size_t                   tokenBytes = 0;
+};
+
+size_t repetitions = 5;
+size_t corpusSize  = 16 << 20;
+size_t sink        = 0;
+
+template <size_t N>
+std::vector<Variant> multiByteVariants() {
+  return {
+      {"map", [] { return std::make_shared<MapTransitionChooser<N>>(); },
+       false},
+      {"interval",
+       [] { return std::make_shared<IntervalTransitionChooser<N>>(); }, false},
+      {"hash", [] { return std::make_shared<HashTransitionChooser<N>>(); },
+       false},
+  };
+}
+
+std::vector<Variant> variants() {
+  return {
+      {"map", [] { return std::make_shared<MapTransitionChooser<1>>(); },
+       false},
+      {"array", [] { return std::make_shared<ArrayTransitionChooser>(); },
+       false},
+      {"interval",
+       [] { return std::make_shared<IntervalTransitionChooser<1>>(); }, false},
+      {"compiled", [] { return std::make_shared<ArrayTransitionChooser>(); },
+       true},
+  };
+}
+
+void report(std::string const& machine, std::string const& mode,
+            std::string const& variant, size_t bytes, size_t transitions,
+            double seconds) {
+  std::printf("%-10s %-8s %-10s %10.1f MB/s %8.2f ns/byte %10.1f Mtrans/s\n",
+              machine.c_str(), mode.c_str(), variant.c_str(),
+              bytes / seconds / 1e6, seconds * 1e9 / bytes,
+              transitions / seconds / 1e6);
+}
+
+template <typename F>
+double measure(F const& f) {
+  double best = 1e30;
+  for (size_t r = 0; r < repetitions; ++r) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto end = std::chrono::steady_clock::now();
+    auto seconds = std::chrono::duration<double>(end - start).count();
+    best         = std::min(best, seconds);
+  }
+  return best;
+}
+
+// path of file in temporary directory
+std::string tempPath(std::string const& file) {
+  for (auto const& variable : {"TMPDIR", "TMP", "TEMP"})
+    if (auto const dir = std::getenv(variable))
+      return std::string(dir) + "/" + file;
+  return "/tmp/" + file;
+}
+
+void benchParse(std::string const& name, MachineBuilder const& build,
+                Corpus const& corpus,
+                std::vector<Variant> const& variants = variants(),
+                size_t                      symbolSize = 1) {
+  auto const& data = corpus.stream;
+  for (auto const& v : variants) {
+    MealyMachine mm(symbolSize);
+    build(mm, v.chooser);
+    if (v.compile) mm.compile();
+    auto seconds = measure([&] {
+      mm.begin();
+      size_t const chunk = 1 << 16;
+      for (size_t offset = 0; offset < data.size(); offset += chunk) {
+        auto size = std::min(chunk, data.size() - offset);
+        if (!mm.parse((MealyMachine::BasicUnit const*)data.data() + offset,
+                      size))
+          std::abort();
+      }
+      sink += mm.end();
+    });
+    report(name, "parse", v.name, data.size(), data.size() / symbolSize + 1,
+           seconds);
+  }
+}
+
+void benchMatch(std::string const& name, MachineBuilder const& build,
+                Corpus const& corpus) {
+  for (auto const& v : variants()) {
+    MealyMachine mm;
+    build(mm, v.chooser);
+    if (v.compile) mm.compile();
+    auto seconds = measure([&] {
+      for (auto const& token : corpus.tokens)
+        sink += mm.match((MealyMachine::BasicUnit const*)token.data(),
+                         token.size());
+    });
+    report(name, "match", v.name, corpus.tokenBytes,
+           corpus.tokenBytes + corpus.tokens.size(), seconds);
+  }
+}
+
+void benchDeferred(std::string const& name, MachineBuilder const& build,
+                   Corpus const& corpus) {
+  auto const&  data = corpus.stream;
+  MealyMachine mm;
+  build(mm, [] { return std::make_shared<ArrayTransitionChooser>(); });
+  mm.compile();
+  mm.setDeferred(true);
+  mm.begin();
+  mm.parse((MealyMachine::BasicUnit const*)data.data(), data.size());
+  mm.end();
+  mm.reserveActionLog(mm.getActionLog().size());
+  mm.replay();
+  auto scan = measure([&] {
+    mm.begin();
+    if (!mm.parse((MealyMachine::BasicUnit const*)data.data(), data.size()))
+      std::abort();
+    sink += mm.end();
+    sink += mm.getActionLog().size();
+    mm.replay();
+  });
+  report(name, "parse", "deferred", data.size(), data.size() + 1, scan);
+}
+
+void benchLex(std::string const& name, MachineBuilder const& build,
+              Corpus const& corpus) {
+  auto const&  data = corpus.stream;
+  MealyMachine mm;
+  build(mm, [] { return std::make_shared<ArrayTransitionChooser>(); });
+  mm.compile();
+  std::vector<MealyMachine::TokenRecord> tokens(1 << 16);
+  mm.setTokenBuffer(tokens.data(), tokens.size());
+  auto seconds = measure([&] {
+    mm.begin();
+    size_t const chunk = 1 << 12;
+    for (size_t offset = 0; offset < data.size(); offset += chunk) {
+      auto size = std::min(chunk, data.size() - offset);
+      if (!mm.lex((MealyMachine::BasicUnit const*)data.data() + offset, size))
+        std::abort();
+      sink += mm.getNofTokens();
+      mm.clearTokens();
+    }
+    sink += mm.endLex();
+  });
+  report(name, "lex", "compiled", data.size(), data.size(), seconds);
+}
+
+// std::regex is slow, it is measured on a fraction of tokens
+void benchRegex(std::string const& name, std::string const& pattern,
+                Corpus const& corpus) {
+  auto         mm = compileRegex(pattern);
+  std::regex   re(pattern, std::regex::optimize);
+  size_t const fraction = 64;
+  std::vector<std::string> tokens;
+  size_t                   bytes = 0;
+  for (size_t i = 0; i < corpus.tokens.size(); i += fraction) {
+    tokens.push_back(corpus.tokens[i]);
+    bytes += corpus.tokens[i].size();
+  }
+  for (auto const& token : tokens)
+    if (mm.match(token.c_str()) != std::regex_match(token, re)) std::abort();
+  auto seconds = measure([&] {
+    for (auto const& token : tokens)
+      sink += mm.match((MealyMachine::BasicUnit const*)token.data(),
+                       token.size());
+  });
+  report(name, "match", "regex", bytes, bytes + tokens.size(), seconds);
+  auto const stdSeconds = measure([&] {
+    for (auto const& token : tokens) sink += std::regex_match(token, re);
+  });
+  report(name, "match", "std::regex", bytes, bytes + tokens.size(),
+         stdSeconds);
+  std::printf("%-10s match    regex is %.1fx faster than std::regex\n",
+              name.c_str(), stdSeconds / seconds);
+}
+
+void benchInterleaved(std::string const& name, MachineBuilder const& build,
+                      Corpus const& corpus) {
+  MealyMachine mm;
+  build(mm, [] { return std::make_shared<ArrayTransitionChooser>(); });
+  mm.compile();
+  std::vector<MealyMachine::Buffer> inputs;
+  for (auto const& token : corpus.tokens)
+    inputs.push_back(
+        {(MealyMachine::BasicUnit const*)token.data(), token.size()});
+  std::vector<uint8_t> results(inputs.size());
+  auto seconds = measure([&] {
+    mm.matchInterleaved(inputs.data(), inputs.size(), results.data());
+    sink += results.back();
+  });
+  report(name, "match", "interleaved", corpus.tokenBytes,
+         corpus.tokenBytes + corpus.tokens.size(), seconds);
+}
+
+void benchMatchMany(std::string const& name, MachineBuilder const& build,
+                    Corpus const& corpus) {
+  auto const   threads = std::max(std::thread::hardware_concurrency(), 1u);
+  MealyMachine mm;
+  build(mm, [] { return std::make_shared<ArrayTransitionChooser>(); });
+  mm.compile();
+  std::vector<MealyMachine::Buffer> inputs;
+  for (auto const& token : corpus.tokens)
+    inputs.push_back(
+        {(MealyMachine::BasicUnit const*)token.data(), token.size()});
+  std::vector<uint8_t> results(inputs.size());
+  for (size_t t = 1; t <= threads; t *= 2) {
+    ThreadPool          pool(t);
+    std::vector<Cursor> cursors;
+    auto seconds = measure([&] {
+      mm.matchMany(inputs.data(), inputs.size(), results.data(), pool,
+                   cursors);
+      sink += results.back();
+    });
+    report(name, "many", std::to_string(t) + " threads", corpus.tokenBytes,
+           corpus.tokenBytes + corpus.tokens.size(), seconds);
+  }
+}
+
+void benchParallel(std::string const& name, MachineBuilder const& build,
+                   Corpus const& corpus) {
+  auto const& data    = corpus.stream;
+  auto const  threads = std::max(std::thread::hardware_concurrency(), 1u);
+  MealyMachine mm;
+  build(mm, [] { return std::make_shared<ArrayTransitionChooser>(); });
+  mm.compile();
+  for (size_t t = 1; t <= threads; t *= 2) {
+    auto seconds = measure([&] {
+      mm.begin();
+      if (!mm.parseParallel((MealyMachine::BasicUnit const*)data.data(),
+                            data.size(), t))
+        std::abort();
+      sink += mm.end();
+    });
+    report(name, "parallel", std::to_string(t) + " threads", data.size(),
+           data.size() + 1, seconds);
+  }
+}
+
+// patterns are random substrings of the stream
+void benchAhoCorasick(std::string const& name, Corpus const& corpus,
+                      size_t nofPatterns) {
+  auto const&        data = corpus.stream;
+  std::mt19937       generator(4321);
+  AhoCorasickBuilder builder;
+  while (builder.getNofPatterns() < nofPatterns) {
+    auto length = std::uniform_int_distribution<size_t>(4, 12)(generator);
+    auto begin  = std::uniform_int_distribution<size_t>(
+        0, data.size() - length)(generator);
+    builder.addPattern(data.substr(begin, length));
+  }
+  size_t matches = 0;
+  MealyMachine mm;
+  auto         seconds = measure([&] {
+    mm = builder.build([&](MealyMachine*, size_t, size_t) { ++matches; });
+  });
+  std::printf("%-10s build %zu patterns in %.1f ms\n", name.c_str(),
+              nofPatterns, seconds * 1e3);
+  auto const path = tempPath(name + "AhoCorasick.bin");
+  mm.save(path);
+  seconds = measure([&] { sink += MealyMachine::load(path).isCompiled(); });
+  std::printf("%-10s load %zu patterns in %.3f ms\n", name.c_str(),
+              nofPatterns, seconds * 1e3);
+  std::remove(path.c_str());
+  seconds = measure([&] {
+    mm.begin();
+    if (!mm.parse((MealyMachine::BasicUnit const*)data.data(), data.size()))
+      std::abort();
+    sink += mm.end();
+  });
+  sink += matches;
+  report(name, "search", std::to_string(nofPatterns) + " patterns",
+         data.size(), data.size() + 1, seconds);
+}
+
+std::mt19937& random() {
+  static std::mt19937 generator(1234);
+  return generator;
+}
+
+size_t uniform(size_t from, size_t to) {
+  return std::uniform_int_distribution<size_t>(from, to)(random());
+}
+
+std::string digits(size_t n) {
+  std::string result;
+  for (size_t i = 0; i < n; ++i) result += char('0' + uniform(0, 9));
+  return result;
+}
+
+std::string word(size_t n) {
+  std::string result;
+  for (size_t i = 0; i < n; ++i) result += char('a' + uniform(0, 25));
+  return result;
+}
+
+void addTokens(Corpus& corpus, std::function<std::string()> const& token) {
+  while (corpus.tokenBytes < corpusSize) {
+    corpus.tokens.push_back(token());
+    corpus.tokenBytes += corpus.tokens.back().size();
+  }
+}
+
+void addStream(Corpus& corpus, std::function<std::string()> const& chunk) {
+  while (corpus.stream.size() < corpusSize) corpus.stream += chunk();
+}
+
+// float literals like +1.25e-3f
+void buildFloat(MealyMachine& mm, ChooserFactory const& chooser) {
+  auto start            = mm.addState(chooser(), "start");
+  auto sign             = mm.addState(chooser(), "sign");
+  auto immediateDot     = mm.addState(chooser(), "immediateDot");
+  auto fractionalNumber = mm.addState(chooser(), "fractionalNumber");
+  auto wholeNumber      = mm.addState(chooser(), "wholeNumber");
+  auto exponent         = mm.addState(chooser(), "exponent");
+  auto postfix          = mm.addState(chooser(), "postfix");
+  auto exponentSign     = mm.addState(chooser(), "exponentSign");
+  auto exponentNumber   = mm.addState(chooser(), "exponentNumber");
+  mm.addTransition(start, "+-", sign);
+  mm.addTransition(start, ".", immediateDot);
+  mm.addTransition(start, "0", "9", wholeNumber);
+  mm.addTransition(sign, ".", immediateDot);
+  mm.addTransition(sign, "0", "9", wholeNumber);
+  mm.addTransition(immediateDot, "0", "9", fractionalNumber);
+  mm.addTransition(wholeNumber, "0", "9", wholeNumber);
+  mm.addTransition(wholeNumber, ".", fractionalNumber);
+  mm.addTransition(wholeNumber, "fF", postfix);
+  mm.addTransition(wholeNumber, "eE", exponent);
+  mm.addEOFTransition(wholeNumber);
+  mm.addTransition(fractionalNumber, "0", "9", fractionalNumber);
+  mm.addTransition(fractionalNumber, "fF", postfix);
+  mm.addTransition(fractionalNumber, "eE", exponent);
+  mm.addEOFTransition(fractionalNumber);
+  mm.addEOFTransition(postfix);
+  mm.addTransition(exponent, "+-", exponentSign);
+  mm.addTransition(exponent, "0", "9", exponentNumber);
+  mm.addTransition(exponentSign, "0", "9", exponentNumber);
+  mm.addTransition(exponentNumber, "0", "9", exponentNumber);
+  mm.addTransition(exponentNumber, "fF", postfix);
+  mm.addEOFTransition(exponentNumber);
+  mm.setQuiet(true);
+}
+
+Corpus floatCorpus() {
+  Corpus corpus;
+  addTokens(corpus, [] {
+    std::string result;
+    if (uniform(0, 3) == 0) result += "+-"[uniform(0, 1)];
+    result += digits(uniform(1, 8));
+    if (uniform(0, 1)) result += "." + digits(uniform(0, 8));
+    if (uniform(0, 3) == 0)
+      result += "eE"[uniform(0, 1)] + digits(uniform(1, 2));
+    if (uniform(0, 3) == 0) result += "f";
+    return result;
+  });
+  return corpus;
+}
+
+// comma separated values with quoted fields
+void buildCsv(MealyMachine& mm, ChooserFactory const& chooser) {
+  auto fieldStart    = mm.addState(chooser(), "fieldStart");
+  auto unquoted      = mm.addState(chooser(), "unquoted");
+  auto quoted        = mm.addState(chooser(), "quoted");
+  auto quoteInQuoted = mm.addState(chooser(), "quoteInQuoted");
+  auto fields        = std::make_shared<size_t>(0);
+  auto rows          = std::make_shared<size_t>(0);
+  auto field         = [fields](MealyMachine*) { (*fields)++; };
+  auto row           = [fields, rows](MealyMachine*) {
+    (*fields)++;
+    (*rows)++;
+  };
+  mm.addTransition(fieldStart, "\"", quoted);
+  mm.addTransition(fieldStart, ",", fieldStart, field);
+  mm.addTransition(fieldStart, "\n", fieldStart, row);
+  mm.addElseTransition(fieldStart, unquoted);
+  mm.addEOFTransition(fieldStart);
+  mm.addTransition(unquoted, ",", fieldStart, field);
+  mm.addTransition(unquoted, "\n", fieldStart, row);
+  mm.addElseTransition(unquoted, unquoted);
+  mm.addEOFTransition(unquoted, row);
+  mm.addTransition(quoted, "\"", quoteInQuoted);
+  mm.addElseTransition(quoted, quoted);
+  mm.addTransition(quoteInQuoted, "\"", quoted);
+  mm.addTransition(quoteInQuoted, ",", fieldStart, field);
+  mm.addTransition(quoteInQuoted, "\n", fieldStart, row);
+  mm.addEOFTransition(quoteInQuoted, row);
+}
+
+Corpus csvCorpus() {
+  Corpus corpus;
+  addStream(corpus, [] {
+    std::string line;
+    for (size_t f = 0; f < 8; ++f) {
+      if (f) line += ",";
+      switch (uniform(0, 2)) {
+        case 0: line += digits(uniform(1, 10)); break;
+        case 1: line += word(uniform(1, 12)); break;
+        case 2:
+          line += "\"" + word(uniform(1, 6)) + ", \"\"" + word(3) + "\"\"\"";
+          break;
+      }
+    }
+    return line + "\n";
+  });
+  return corpus;
+}
+
+// json-like tokens: punctuation, strings, numbers and words
+void buildJson(MealyMachine& mm, ChooserFactory const& chooser) {
+  auto start  = mm.addState(chooser(), "start");
+  auto string = mm.addState(chooser(), "string");
+  auto escape = mm.addState(chooser(), "escape");
+  auto number = mm.addState(chooser(), "number");
+  auto name   = mm.addState(chooser(), "word");
+  auto tokens = std::make_shared<size_t>(0);
+  auto token  = [tokens](MealyMachine*) { (*tokens)++; };
+  auto last   = [tokens](MealyMachine* m) {
+    m->dontMove();
+    (*tokens)++;
+  };
+  mm.addTransition(start, " \t\r\n", start);
+  mm.addTransition(start, "{}[]:,", start, token);
+  mm.addTransition(start, "\"", string);
+  mm.addTransition(start, "-", number);
+  mm.addTransition(start, "0", "9", number);
+  mm.addTransition(start, "a", "z", name);
+  mm.addEOFTransition(start);
+  mm.addTransition(string, "\\", escape);
+  mm.addTransition(string, "\"", start, token);
+  mm.addElseTransition(string, string);
+  mm.addElseTransition(escape, string);
+  mm.addTransition(number, "0", "9", number);
+  mm.addTransition(number, ".eE+-", number);
+  mm.addElseTransition(number, start, last);
+  mm.addEOFTransition(number, token);
+  mm.addTransition(name, "a", "z", name);
+  mm.addElseTransition(name, start, last);
+  mm.addEOFTransition(name, token);
+}
+
+Corpus jsonCorpus() {
+  Corpus corpus;
+  addStream(corpus, [] {
+    std::string object = "{";
+    for (size_t i = 0; i < 6; ++i) {
+      if (i) object += ", ";
+      object += "\"" + word(uniform(2, 10)) + "\": ";
+      switch (uniform(0, 3)) {
+        case 0: object += digits(uniform(1, 6)) + "." + digits(2); break;
+        case 1: object += "\"" + word(uniform(0, 20)) + "\\n\""; break;
+        case 2: object += "[true, false, null]"; break;
+        case 3: object += "-" + digits(uniform(1, 9)) + "e+1"; break;
+      }
+    }
+    return object + "}\n";
+  });
+  return corpus;
+}
+
+// log lines: date time [LEVEL] message
+void buildLogLines(MealyMachine& mm, ChooserFactory const& chooser,
+                   MealyMachine::Callback const& line) {
+  auto date      = mm.addState(chooser(), "date");
+  auto time      = mm.addState(chooser(), "time");
+  auto levelOpen = mm.addState(chooser(), "levelOpen");
+  auto level     = mm.addState(chooser(), "level");
+  auto message   = mm.addState(chooser(), "message");
+  mm.addTransition(date, "0", "9", date);
+  mm.addTransition(date, "-", date);
+  mm.addTransition(date, " ", time);
+  mm.addEOFTransition(date);
+  mm.addTransition(time, "0", "9", time);
+  mm.addTransition(time, ":.", time);
+  mm.addTransition(time, " ", levelOpen);
+  mm.addTransition(levelOpen, "[", level);
+  mm.addTransition(level, "A", "Z", level);
+  mm.addTransition(level, "]", message);
+  mm.addTransition(message, "\n", date, line);
+  mm.addElseTransition(message, message);
+}
+
+void buildLog(MealyMachine& mm, ChooserFactory const& chooser) {
+  auto lines = std::make_shared<size_t>(0);
+  buildLogLines(mm, chooser, [lines](MealyMachine*) { (*lines)++; });
+}
+
+// tokens of log lines for longest match lexer
+void buildLogTokens(MealyMachine& mm, ChooserFactory const& chooser) {
+  auto start  = mm.addState(chooser(), "start");
+  auto word   = mm.addState(chooser(), "word");
+  auto number = mm.addState(chooser(), "number");
+  auto space  = mm.addState(chooser(), "space");
+  auto punct  = mm.addState(chooser(), "punctuation");
+  mm.addTransition(start, "a", "z", word);
+  mm.addTransition(start, "A", "Z", word);
+  mm.addTransition(word, "a", "z", word);
+  mm.addTransition(word, "A", "Z", word);
+  mm.addTransition(start, "0", "9", number);
+  mm.addTransition(number, "0", "9", number);
+  mm.addTransition(start, " \n", space);
+  mm.addTransition(space, " \n", space);
+  mm.addTransition(start, "-:.[]", punct);
+  mm.setAccepting(word, 0);
+  mm.setAccepting(number, 1);
+  mm.setAccepting(space, 2);
+  mm.setAccepting(punct, 3);
+}
+
+// validation only, without callbacks
+void buildLogValidator(MealyMachine& mm, ChooserFactory const& chooser) {
+  buildLogLines(mm, chooser, nullptr);
+}
+
+Corpus logCorpus() {
+  Corpus corpus;
+  char const* levels[] = {"INFO", "WARN", "ERROR", "DEBUG"};
+  addStream(corpus, [&] {
+    std::string line = "2024-0" + digits(1) + "-1" + digits(1) + " ";
+    line += "1" + digits(1) + ":" + digits(2) + ":" + digits(2) + "." +
+            digits(3) + " [";
+    line += levels[uniform(0, 3)];
+    line += "] " + word(uniform(3, 10)) + ": ";
+    for (size_t w = uniform(3, 12); w > 0; --w)
+      line += word(uniform(1, 9)) + " ";
+    return line + "\n";
+  });
+  return corpus;
+}
+
+// counter and dontMove of one action of buildOperators
+struct OperatorAction {
+  size_t counter;
+  bool   dontMove;
+};
+
+// + - ++ -- counter from README
+// actions are appended to actions in order in which they are added to mm
+void buildOperatorActions(MealyMachine& mm, ChooserFactory const& chooser,
+                          std::vector<OperatorAction>& actions) {
+  auto counters = std::make_shared<std::vector<size_t>>(5, 0);
+  auto S        = mm.addState(chooser());
+  auto P        = mm.addState(chooser());
+  auto M        = mm.addState(chooser());
+  auto E        = mm.addState(chooser());
+  auto count    = [counters, &actions](size_t i, bool dontMove) {
+    actions.push_back({i, dontMove});
+    return [counters, i, dontMove](MealyMachine* m) {
+      if (dontMove) m->dontMove();
+      (*counters)[i]++;
+    };
+  };
+  mm.addTransition(S, "+", P);
+  mm.addTransition(S, "-", M);
+  mm.addElseTransition(S, E, count(4, false));
+  mm.addEOFTransition(S);
+  mm.addTransition(P, "+", S, count(1, false));
+  mm.addTransition(P, "-", M, count(0, false));
+  mm.addElseTransition(P, S, count(0, true));
+  mm.addEOFTransition(P, count(0, false));
+  mm.addTransition(M, "-", S, count(3, false));
+  mm.addTransition(M, "+", P, count(2, false));
+  mm.addElseTransition(M, S, count(2, true));
+  mm.addEOFTransition(M, count(2, false));
+  mm.addElseTransition(E, E, count(4, false));
+  mm.addEOFTransition(E);
+}
+
+void buildOperators(MealyMachine& mm, ChooserFactory const& chooser) {
+  std::vector<OperatorAction> actions;
+  buildOperatorActions(mm, chooser, actions);
+}
+
+Corpus operatorCorpus() {
+  Corpus corpus;
+  addStream(corpus, [] {
+    std::string result;
+    for (size_t i = 0; i < 64; ++i) result += "+- "[uniform(0, 2)];
+    return result;
+  });
+  addTokens(corpus, [] {
+    std::string result;
+    for (size_t i = uniform(1, 16); i > 0; --i) result += "+-"[uniform(0, 1)];
+    return result + word(uniform(0, 4));
+  });
+  return corpus;
+}
+
+// actions of buildOperators dispatched by their ids
+struct OperatorActions {
+  std::vector<OperatorAction> actions;
+  size_t                      counters[5] = {};
+  void operator()(uint32_t action, BasicMealyMachine<OperatorActions>* m) {
+    auto const& a = actions[action];
+    if (a.dontMove) m->dontMove();
+    counters[a.counter]++;
+  }
+};
+
+void benchStaticDispatch(std::string const& name, Corpus const& corpus) {
+  auto const& data = corpus.stream;
+  MealyMachine    mm;
+  OperatorActions actions;
+  buildOperatorActions(
+      mm, [] { return std::make_shared<ArrayTransitionChooser>(); },
+      actions.actions);
+  mm.compile();
+  BasicMealyMachine<OperatorActions> basic(mm, actions);
+  auto seconds = measure([&] {
+    basic.begin();
+    if (!basic.parse((MealyMachine::BasicUnit const*)data.data(), data.size()))
+      std::abort();
+    sink += basic.end() + basic.getActions().counters[0];
+  });
+  report(name, "parse", "static", data.size(), data.size() + 1, seconds);
+}
+
+// binary protocol with N byte opcodes, every 4th opcode has operand
+template <size_t N>
+std::vector<std::string> const& opcodes() {
+  static std::vector<std::string> result = [] {
+    std::mt19937             generator(N);
+    std::vector<std::string> codes;
+    for (size_t i = 0; i < 200; ++i) {
+      std::string code;
+      for (size_t b = 0; b < N; ++b) code += char(generator());
+      codes.push_back(code);
+    }
+    return codes;
+  }();
+  return result;
+}
+
+template <size_t N>
+void buildOpcodes(MealyMachine& mm, ChooserFactory const& chooser) {
+  auto        opcode   = mm.addState(chooser(), "opcode");
+  auto        operand  = mm.addState(chooser(), "operand");
+  auto        commands = std::make_shared<size_t>(0);
+  auto const& codes    = opcodes<N>();
+  for (size_t i = 0; i < codes.size(); ++i)
+    mm.addTransition(opcode, codes[i], i % 4 ? opcode : operand,
+                     [commands](MealyMachine*) { (*commands)++; });
+  mm.addEOFTransition(opcode);
+  mm.addElseTransition(operand, opcode);
+}
+
+template <size_t N>
+Corpus opcodeCorpus() {
+  Corpus corpus;
+  addStream(corpus, [] {
+    auto const& codes = opcodes<N>();
+    auto        index = uniform(0, codes.size() - 1);
+    auto        code  = codes[index];
+    if (index % 4 == 0) code += std::string(N, 'x');
+    return code;
+  });
+  return corpus;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  if (argc > 1) corpusSize = std::strtoul(argv[1], nullptr, 10) << 20;
+  if (argc > 2) repetitions = std::strtoul(argv[2], nullptr, 10);
+  if (corpusSize == 0 || repetitions == 0) {
+    std::cerr << "usage: " << argv[0] << " [corpus size in MB] [repetitions]"
+              << std::endl;
+    return 1;
+  }
+
+  auto floats = floatCorpus();
+  benchMatch("float", buildFloat, floats);
+  benchInterleaved("float", buildFloat, floats);
+  benchRegex("float", "[+-]?(\\d+\\.?\\d*|\\.\\d+)([eE][+-]?\\d+)?[fF]?",
+             floats);
+  benchMatchMany("float", buildFloat, floats);
+  auto csv = csvCorpus();
+  benchParse("csv", buildCsv, csv);
+  benchDeferred("csv", buildCsv, csv);
+  benchParse("json", buildJson, jsonCorpus());
+  auto log = logCorpus();
+  benchParse("log", buildLog, log);
+  benchParallel("log", buildLogValidator, log);
+  benchLex("log", buildLogTokens, log);
+  benchAhoCorasick("log", log, 10000);
+  auto operators = operatorCorpus();
+  benchParse("operators", buildOperators, operators);
+  benchMatch("operators", buildOperators, operators);
+  benchStaticDispatch("operators", operators);
+  benchParse("opcodes2", buildOpcodes<2>, opcodeCorpus<2>(),
+             multiByteVariants<2>(), 2);
+  benchParse("opcodes4", buildOpcodes<4>, opcodeCorpus<4>(),
+             multiByteVariants<4>(), 4);
+
+  return sink == 0xdeadbeef;
+}
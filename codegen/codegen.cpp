@@ -0,0 +1,59 @@
+/*!
+ * @file
+ * @brief This file contains generator of direct coded C++ scanners.
+ * It writes header generated by MealyMachine::emitCpp from machine saved by
+ * MealyMachine::save or from regular expression.
+ *
+ * usage: mealy-codegen <machine file> <class name> [output header]
+ *        mealy-codegen --regex <pattern> <class name> [output header]
+ */
+
+#include <MealyMachine/Exception.h>
+#include <MealyMachine/MealyMachine.h>
+#include <MealyMachine/Regex.h>
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+using namespace mealyMachine;
+
+int usage() {
+  std::cerr << "usage: mealy-codegen <machine file> <class name> [output "
+               "header]\n";
+  std::cerr << "       mealy-codegen --regex <pattern> <class name> [output "
+               "header]\n";
+  return 1;
+}
+
+int main(int argc, char* argv[]) {
+  int        arg   = 1;
+  bool const regex = argc > 1 && std::string(argv[1]) == "--regex";
+  if (regex) ++arg;
+  if (argc - arg < 2 || argc - arg > 3) return usage();
+  std::string const source = argv[arg];
+  std::string const name   = argv[arg + 1];
+  try {
+    auto const mm = regex ? compileRegex(source) : MealyMachine::load(source);
+    if (argc - arg == 2) {
+      mm.emitCpp(std::cout, name);
+      return 0;
+    }
+    std::ofstream out(argv[arg + 2]);
+    if (!out) {
+      std::cerr << "mealy-codegen - " << argv[arg + 2]
+                << " cannot be created\n";
+      return 1;
+    }
+    mm.emitCpp(out, name);
+    if (!out) {
+      std::cerr << "mealy-codegen - " << argv[arg + 2]
+                << " cannot be written\n";
+      return 1;
+    }
+  } catch (ex::Exception const& e) {
+    std::cerr << e.what() << "\n";
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,180 @@
+#include <sstream>
+
+#include <MealyMachine/AhoCorasickBuilder.h>
+#include <MealyMachine/Exception.h>
+
+using namespace mealyMachine;
+
+namespace {
+
+/**
+ * @brief This structure contains patterns that end in states.
+ * Patterns of state s are patterns[first[s]..first[s+1]), patterns that end
+ * in proper suffixes of s are found by following dictionary links.
+ * It is shared by all actions of the machine.
+ */
+struct Outputs {
+  std::vector<uint32_t>             first;
+  std::vector<uint32_t>             patterns;
+  std::vector<uint32_t>             dictionary;
+  std::vector<uint32_t>             lengths;
+  AhoCorasickBuilder::MatchCallback onMatch;
+};
+
+}  // namespace
+
+size_t AhoCorasickBuilder::addPattern(std::string const& pattern) {
+  if (pattern.empty()) {
+    std::stringstream ss;
+    ss << "MealyMachine::AhoCorasickBuilder::addPattern - ";
+    ss << "pattern cannot be empty";
+    throw ex::Exception(ss.str());
+  }
+  _patterns.push_back(pattern);
+  return _patterns.size() - 1;
+}
+
+size_t AhoCorasickBuilder::getNofPatterns() const { return _patterns.size(); }
+
+MealyMachine AhoCorasickBuilder::build(MatchCallback const& onMatch) const {
+  using Cell          = MealyMachine::CompiledTransition;
+  auto const none     = MealyMachine::nonexistingCompiledState;
+  auto const noAction = MealyMachine::noCompiledAction;
+  auto const tooLarge = [] {
+    std::stringstream ss;
+    ss << "MealyMachine::AhoCorasickBuilder::build - ";
+    ss << "automaton is too large";
+    throw ex::Exception(ss.str());
+  };
+
+  // every byte of patterns has its own class, other bytes share one class,
+  // equivalent classes are merged when the table is resolved
+  std::vector<bool> used(MealyMachine::compiledSymbols, false);
+  for (auto const& pattern : _patterns)
+    for (auto const& c : pattern) used[static_cast<uint8_t>(c)] = true;
+  std::vector<uint8_t> classes(MealyMachine::compiledSymbols);
+  size_t               nofClasses = 0;
+  for (size_t symbol = 0; symbol < used.size(); ++symbol)
+    if (used[symbol]) classes[symbol] = static_cast<uint8_t>(nofClasses++);
+  if (nofClasses < MealyMachine::compiledSymbols) {
+    for (size_t symbol = 0; symbol < used.size(); ++symbol)
+      if (!used[symbol]) classes[symbol] = static_cast<uint8_t>(nofClasses);
+    ++nofClasses;
+  }
+
+  // trie
+  size_t                nofStates = 1;
+  std::vector<Cell>     cells(nofClasses, Cell{none, noAction});
+  std::vector<uint32_t> patternEnd(_patterns.size());
+  for (size_t p = 0; p < _patterns.size(); ++p) {
+    uint32_t s = 0;
+    for (auto const& c : _patterns[p]) {
+      auto const cell = s * nofClasses + classes[static_cast<uint8_t>(c)];
+      if (cells[cell].state == none) {
+        if (nofStates >= none) tooLarge();
+        cells[cell].state = static_cast<uint32_t>(nofStates++);
+        cells.resize(nofStates * nofClasses, Cell{none, noAction});
+      }
+      s = cells[cell].state;
+    }
+    patternEnd[p] = s;
+  }
+
+  // failure links in breadth first order, missing edges are resolved
+  // using already resolved edges of failure state
+  std::vector<uint32_t> fail(nofStates, 0);
+  std::vector<uint32_t> order = {0};
+  order.reserve(nofStates);
+  for (size_t i = 0; i < order.size(); ++i) {
+    auto const u = order[i];
+    for (size_t c = 0; c < nofClasses; ++c) {
+      auto&      cell     = cells[u * nofClasses + c];
+      auto const resolved = u == 0 ? 0 : cells[fail[u] * nofClasses + c].state;
+      if (cell.state == none) {
+        cell.state = resolved;
+        continue;
+      }
+      fail[cell.state] = resolved;
+      order.push_back(cell.state);
+    }
+  }
+
+  auto outputs     = std::make_shared<Outputs>();
+  outputs->onMatch = onMatch;
+  outputs->first.assign(nofStates + 1, 0);
+  outputs->patterns.resize(_patterns.size());
+  outputs->dictionary.assign(nofStates, none);
+  for (auto const& s : patternEnd) outputs->first[s + 1]++;
+  for (size_t s = 0; s < nofStates; ++s)
+    outputs->first[s + 1] += outputs->first[s];
+  {
+    auto fill = outputs->first;
+    for (size_t p = 0; p < _patterns.size(); ++p) {
+      outputs->patterns[fill[patternEnd[p]]++] = static_cast<uint32_t>(p);
+      outputs->lengths.push_back(static_cast<uint32_t>(_patterns[p].size()));
+    }
+  }
+  auto const hasOwn = [&](uint32_t s) {
+    return outputs->first[s + 1] > outputs->first[s];
+  };
+  for (size_t i = 1; i < order.size(); ++i) {
+    auto const s           = order[i];
+    auto const f           = fail[s];
+    outputs->dictionary[s] = hasOwn(f) ? f : outputs->dictionary[f];
+  }
+
+  // occurrences are reported when the machine leaves the state where they
+  // end, states with the same occurrences share one action that knows the
+  // first state of its dictionary chain, so actions do not depend on
+  // numbering of states of the machine
+  MealyMachine          mm;
+  auto&                 definition = *mm._editable;
+  std::vector<uint32_t> actionOf(nofStates, noAction);
+  for (size_t s = 0; s < nofStates; ++s) {
+    auto const head = hasOwn(static_cast<uint32_t>(s))
+                          ? static_cast<uint32_t>(s)
+                          : outputs->dictionary[s];
+    if (head == none) continue;
+    if (actionOf[head] == noAction) {
+      actionOf[head] = static_cast<uint32_t>(definition.actions.size());
+      MealyMachine::Action action;
+      action.callback = [outputs, head](MealyMachine* machine) {
+        auto const end = machine->getReadingPosition();
+        for (auto t = head; t != MealyMachine::nonexistingCompiledState;
+             t      = outputs->dictionary[t])
+          for (auto i = outputs->first[t]; i < outputs->first[t + 1]; ++i) {
+            auto const p = outputs->patterns[i];
+            if (outputs->onMatch)
+              outputs->onMatch(machine, p, end);
+            else
+              machine->_emitToken({end - outputs->lengths[p], end, p});
+          }
+      };
+      definition.actions.push_back(action);
+    }
+    actionOf[s] = actionOf[head];
+  }
+
+  // every state has EOF transition, it reports occurrences too
+  cells.resize(nofStates * nofClasses + nofStates, Cell{0, noAction});
+  for (size_t s = 0; s < nofStates; ++s) {
+    if (actionOf[s] == noAction) continue;
+    auto* row = cells.data() + s * nofClasses;
+    for (size_t c = 0; c < nofClasses; ++c) row[c].action = actionOf[s];
+    cells[nofStates * nofClasses + s].action = actionOf[s];
+  }
+
+  auto& compiled = definition.compiled;
+  compiled.storage.swap(cells);
+  compiled.classStorage = classes;
+  compiled.acceptStorage.assign(nofStates, MealyMachine::notAccepting);
+  compiled.transitions    = compiled.storage.data();
+  compiled.eofTransitions = compiled.storage.data() + nofStates * nofClasses;
+  compiled.classes        = compiled.classStorage.data();
+  compiled.accepting      = compiled.acceptStorage.data();
+  compiled.nofClasses     = nofClasses;
+  compiled.nofStates      = nofStates;
+  MealyMachine::_mergeClasses(compiled);
+  MealyMachine::_compileLoops(compiled);
+  return mm;
+}
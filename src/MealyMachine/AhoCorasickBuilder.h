@@ -0,0 +1,62 @@
+/*!
+ * @file
+ * @brief This file contains Aho-Corasick multi-pattern matcher builder.
+ */
+
+#pragma once
+
+#include <MealyMachine/MealyMachine.h>
+
+/**
+ * @brief This class builds Mealy machine that finds all occurrences of
+ * literal patterns in input stream.
+ * Goto and failure functions of Aho-Corasick automaton are resolved into
+ * full DFA that is written directly into compiled table, so the machine
+ * does not need interpreted states and every byte costs one table lookup.
+ * Bytes that lead to the same states in every state share one symbol class.
+ */
+class mealyMachine::AhoCorasickBuilder {
+ public:
+  /**
+   * @brief This callback is called for every occurrence of a pattern.
+   * end is the position after the last byte of the occurrence.
+   */
+  using MatchCallback =
+      std::function<void(MealyMachine* machine, size_t pattern, size_t end)>;
+
+  /**
+   * @brief This function adds literal pattern.
+   *
+   * @param pattern non-empty pattern
+   *
+   * @return id of pattern
+   */
+  MEALYMACHINE_EXPORT size_t addPattern(std::string const& pattern);
+
+  /**
+   * @brief This function returns number of added patterns.
+   *
+   * @return number of patterns
+   */
+  MEALYMACHINE_EXPORT size_t getNofPatterns() const;
+
+  /**
+   * @brief This function builds compiled Mealy machine.
+   * The machine accepts every input. If onMatch is nullptr, occurrences
+   * are written into token buffer of the machine as tokens whose kind is
+   * pattern id.
+   * Occurrences are reported when the machine leaves the state where they
+   * end, i.e. on the next symbol or at EOF. States that report the same
+   * occurrences share one action, so the machine can be minimized. The
+   * machine has no interpreted states, so it cannot be extended.
+   *
+   * @param onMatch optional callback of occurrences
+   *
+   * @return compiled Mealy machine
+   */
+  MEALYMACHINE_EXPORT MealyMachine
+  build(MatchCallback const& onMatch = nullptr) const;
+
+ protected:
+  std::vector<std::string> _patterns;
+};
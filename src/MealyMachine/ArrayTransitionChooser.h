@@ -0,0 +1,57 @@
+#pragma once
+
+#include <MealyMachine/TransitionChooser.h>
+#include <array>
+
+/**
+ * @brief This class represents transition chooser for states with 1 byte
+ * symbols.
+ * Every symbol is translated to transition index using direct 256-slot table
+ * so the lookup does not depend on the number of transitions.
+ */
+class mealyMachine::ArrayTransitionChooser
+    : public mealyMachine::TransitionChooser {
+ public:
+  inline ArrayTransitionChooser();
+  virtual MealyMachine::TransitionIndex getTransition(
+      MealyMachine::TransitionSymbol const& data) const override {
+    return _table[data[0]];
+  }
+  virtual bool addTransition(
+      MealyMachine::TransitionSymbol const& data) override {
+    _table[data[0]] = _keys.size();
+    _keys.push_back(_allSymbols() + data[0]);
+    return true;
+  }
+  virtual MealyMachine::TransitionSymbol const& getSymbol(
+      MealyMachine::TransitionIndex const& i) const override {
+    return _keys.at(i);
+  }
+
+ protected:
+  static inline MealyMachine::BasicUnit const* _allSymbols();
+  std::array<MealyMachine::TransitionIndex, 256> _table;
+  std::vector<MealyMachine::TransitionSymbol>    _keys;
+};
+
+inline mealyMachine::ArrayTransitionChooser::ArrayTransitionChooser()
+    : TransitionChooser(1) {
+  _table.fill(MealyMachine::nonexistingTransition);
+}
+
+/**
+ * @brief This function returns table of all 256 symbols.
+ * Keys point into this table so they do not have to be allocated.
+ *
+ * @return table where i-th element is equal to i
+ */
+inline mealyMachine::MealyMachine::BasicUnit const*
+mealyMachine::ArrayTransitionChooser::_allSymbols() {
+  static MealyMachine::BasicUnit const* const symbols = [] {
+    static MealyMachine::BasicUnit table[256];
+    for (size_t i = 0; i < 256; ++i)
+      table[i] = static_cast<MealyMachine::BasicUnit>(i);
+    return table;
+  }();
+  return symbols;
+}
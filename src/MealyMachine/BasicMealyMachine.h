@@ -0,0 +1,254 @@
+/*!
+ * @file
+ * @brief This file contains statically dispatched cursor of compiled Mealy
+ * machine.
+ */
+
+#pragma once
+
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+#include <MealyMachine/Exception.h>
+#include <MealyMachine/MealyMachine.h>
+
+#if defined(__GNUC__)
+#define MEALYMACHINE_LIKELY(x) __builtin_expect(!!(x), 1)
+#else
+#define MEALYMACHINE_LIKELY(x) (x)
+#endif
+
+/**
+ * @brief This class parses compiled table of Mealy machine and dispatches
+ * actions to functor known at compile time.
+ * Actions is called with action id and this cursor:
+ * @code
+ * struct Counter {
+ *   size_t plus = 0;
+ *   size_t minus = 0;
+ *   void operator()(uint32_t action, BasicMealyMachine<Counter>* m) {
+ *     switch (action) {
+ *       case 0: plus++; break;
+ *       case 1: minus++; break;
+ *     }
+ *   }
+ * };
+ * @endcode
+ * The call is not hidden behind std::function, so the compiler can inline
+ * the switch into the scan loop. State that would be captured by lambdas
+ * lives in the functor, it can hold a pointer to user context.
+ * Action ids are ids of MealyMachine actions (see getNofActions), their
+ * callbacks, token marks and programs are ignored. Machines with noMove
+ * programs that compile() could not collapse are rejected.
+ */
+template <typename Actions>
+class mealyMachine::BasicMealyMachine {
+ public:
+  using BasicUnit = MealyMachine::BasicUnit;
+
+  /**
+   * @brief This constructor creates cursor of compiled Mealy machine.
+   * The cursor shares compiled table with the machine.
+   *
+   * @param machine compiled Mealy machine
+   * @param actions functor that executes actions
+   */
+  BasicMealyMachine(MealyMachine const& machine,
+                    Actions const&      actions = Actions());
+
+  /**
+   * @brief This constructor creates cursor of static tables.
+   * It neither allocates nor copies the tables, so a cursor of static
+   * constexpr tables needs no runtime set-up. The tables have to outlive
+   * the cursor.
+   *
+   * @param machine compiled tables
+   * @param actions functor that executes actions
+   */
+  template <size_t nofStates, size_t nofClasses>
+  BasicMealyMachine(StaticMealyMachine<nofStates, nofClasses> const& machine,
+                    Actions const& actions = Actions())
+      : _transitions(machine._transitions),
+        _eofTransitions(machine._eofTransitions),
+        _loops(machine._loops),
+        _classes(machine._classes),
+        _nofClasses(machine._nofClasses),
+        _actions(actions) {}
+
+  /**
+   * @brief This function returns functor that executes actions.
+   *
+   * @return functor
+   */
+  Actions& getActions() { return _actions; }
+
+  /**
+   * @brief This function resets the cursor to start state.
+   */
+  void begin() {
+    _currentState    = 0;
+    _readingPosition = 0;
+  }
+
+  /**
+   * @brief This function parses part of input stream.
+   *
+   * @param data input data
+   * @param size size of input data
+   *
+   * @return false if there is no suitable transition and the cursor is
+   * quiet, it throws otherwise
+   */
+  bool parse(BasicUnit const* data, size_t size);
+
+  /**
+   * @brief This function executes EOF transition.
+   *
+   * @return false if current state has no EOF transition
+   */
+  bool end();
+
+  /**
+   * @brief This function parses whole input.
+   *
+   * @param data input data
+   * @param size size of input data
+   *
+   * @return true if the input is accepted
+   */
+  bool match(BasicUnit const* data, size_t size) {
+    begin();
+    return parse(data, size) && end();
+  }
+
+  /**
+   * @brief This function parses zero terminated string.
+   *
+   * @param data input string
+   *
+   * @return true if the string is accepted
+   */
+  bool match(char const* data) {
+    return match(reinterpret_cast<BasicUnit const*>(data), std::strlen(data));
+  }
+
+  /**
+   * @brief This function prevents the cursor from reading the current
+   * symbol, it can be called from actions.
+   */
+  void dontMove() { _dontMove = true; }
+
+  /**
+   * @brief This function sets quiet mode.
+   * Quiet cursor returns false instead of throwing exception.
+   *
+   * @param quiet true if the cursor should be quiet
+   */
+  void setQuiet(bool quiet) { _quiet = quiet; }
+
+  /**
+   * @brief This function returns position of current symbol in input
+   * stream.
+   *
+   * @return reading position
+   */
+  size_t getReadingPosition() const { return _readingPosition; }
+
+  /**
+   * @brief This function returns current state.
+   *
+   * @return id of current state
+   */
+  size_t getCurrentState() const { return _currentState; }
+
+ protected:
+  bool _noTransition(BasicUnit symbol) const;
+  // null for static tables
+  std::shared_ptr<MealyMachine::Definition const> _definition;
+  MealyMachine::CompiledTransition const*         _transitions;
+  MealyMachine::CompiledTransition const*         _eofTransitions;
+  MealyMachine::CompiledLoop const*               _loops;
+  uint8_t const*                                  _classes;
+  size_t                                          _nofClasses;
+  Actions                                         _actions;
+  uint32_t                                        _currentState    = 0;
+  size_t                                          _readingPosition = 0;
+  bool                                            _dontMove        = false;
+  bool                                            _quiet           = false;
+};
+
+template <typename Actions>
+mealyMachine::BasicMealyMachine<Actions>::BasicMealyMachine(
+    MealyMachine const& machine,
+    Actions const&      actions)
+    : _definition(machine._definition), _actions(actions) {
+  if (!machine.isCompiled())
+    throw ex::Exception(
+        "MealyMachine::BasicMealyMachine - Mealy machine has to be compiled");
+  if (machine._compiledNoMove())
+    throw ex::Exception(
+        "MealyMachine::BasicMealyMachine - programs with noMove are not "
+        "supported");
+  auto const& compiled = _definition->compiled;
+  _transitions         = compiled.transitions;
+  _eofTransitions      = compiled.eofTransitions;
+  _loops               = compiled.loops;
+  _classes             = compiled.classes;
+  _nofClasses          = compiled.nofClasses;
+}
+
+template <typename Actions>
+bool mealyMachine::BasicMealyMachine<Actions>::parse(BasicUnit const* data,
+                                                     size_t           size) {
+  auto const  none       = MealyMachine::nonexistingCompiledState;
+  auto const* table      = _transitions;
+  auto const* classes    = _classes;
+  auto const* loops      = _loops;
+  auto const  nofClasses = _nofClasses;
+  auto const  start      = _readingPosition;
+  auto        state      = _currentState;
+  size_t      read       = 0;
+  while (read < size) {
+    auto const& t = table[state * nofClasses + classes[data[read]]];
+    if (t.action == MealyMachine::noCompiledAction && t.state != none) {
+      ++read;
+      if (t.state == state && size - read >= MealyMachine::minLoopSkip)
+        read = MealyMachine::_skipLoop(loops[state], data, read, size);
+      state = t.state;
+      continue;
+    }
+    _currentState    = state;
+    _readingPosition = start + read;
+    if (t.state == none) return _noTransition(data[read]);
+    _dontMove = false;
+    _actions(t.action, this);
+    state = t.state;
+    // predicted branch, the next lookup does not wait for inlined action
+    if (MEALYMACHINE_LIKELY(!_dontMove)) ++read;
+  }
+  _currentState    = state;
+  _readingPosition = start + read;
+  return true;
+}
+
+template <typename Actions>
+bool mealyMachine::BasicMealyMachine<Actions>::end() {
+  auto const& t = _eofTransitions[_currentState];
+  if (t.state == MealyMachine::nonexistingCompiledState) return false;
+  if (t.action != MealyMachine::noCompiledAction) _actions(t.action, this);
+  return true;
+}
+
+template <typename Actions>
+bool mealyMachine::BasicMealyMachine<Actions>::_noTransition(
+    BasicUnit symbol) const {
+  if (_quiet) return false;
+  std::stringstream ss;
+  ss << "MealyMachine::BasicMealyMachine::parse - ";
+  ss << "there is no suitable transition from state ";
+  ss << _currentState << " using symbol: 0x" << std::setfill('0')
+     << std::setw(2) << std::hex << static_cast<uint32_t>(symbol);
+  ss << " at position: " << std::dec << _readingPosition;
+  throw ex::Exception(ss.str());
+}
@@ -0,0 +1,203 @@
+#include <cctype>
+#include <ostream>
+#include <sstream>
+
+#include <MealyMachine/MealyMachine.h>
+#include <MealyMachine/Exception.h>
+
+using namespace mealyMachine;
+
+namespace {
+
+/**
+ * @brief This structure represents consecutive symbols with the same
+ * transition.
+ */
+struct Run {
+  uint32_t lo;
+  uint32_t hi;
+  uint32_t state;
+  uint32_t action;
+};
+
+bool isIdentifier(std::string const& name) {
+  if (name.empty() || std::isdigit(static_cast<unsigned char>(name[0])))
+    return false;
+  for (auto const& c : name)
+    if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_') return false;
+  return true;
+}
+
+/**
+ * @brief This class writes direct coded scanner.
+ */
+class Emitter {
+ public:
+  Emitter(std::ostream& out, uint32_t none, uint32_t noAction)
+      : _out(out), _none(none), _noAction(noAction) {}
+  void line(size_t indent, std::string const& text) {
+    _out << std::string(2 * indent, ' ') << text << "\n";
+  }
+  void position(size_t indent) {
+    line(indent, "position = base + static_cast<size_t>(p - data);");
+  }
+  void transition(size_t indent, uint32_t from, Run const& run) {
+    if (run.state == _none) {
+      line(indent, "state = " + std::to_string(from) + ";");
+      position(indent);
+      line(indent, "return false;");
+      return;
+    }
+    auto const to = "goto s" + std::to_string(run.state) + ";";
+    if (run.action == _noAction) {
+      line(indent, "++p;");
+      line(indent, to);
+      return;
+    }
+    line(indent, "state = " + std::to_string(from) + ";");
+    position(indent);
+    line(indent, "_dontMove = false;");
+    line(indent, "actions(" + std::to_string(run.action) + "u, this);");
+    line(indent, "if (!_dontMove) ++p;");
+    line(indent, to);
+  }
+  // binary decision tree over runs, runs cover all symbols
+  void runs(size_t                  indent,
+            uint32_t                from,
+            std::vector<Run> const& rs,
+            size_t                  begin,
+            size_t                  end) {
+    if (end - begin == 1) return transition(indent, from, rs[begin]);
+    auto const mid = (begin + end) / 2;
+    line(indent, "if (c < " + std::to_string(rs[mid].lo) + "u) {");
+    runs(indent + 1, from, rs, begin, mid);
+    line(indent, "} else {");
+    runs(indent + 1, from, rs, mid, end);
+    line(indent, "}");
+  }
+
+ protected:
+  std::ostream&  _out;
+  uint32_t const _none;
+  uint32_t const _noAction;
+};
+
+}  // namespace
+
+void MealyMachine::emitCpp(std::ostream& out, std::string const& name) const {
+  _throwIfNotCompiled("emitCpp");
+  if (!isIdentifier(name)) {
+    std::stringstream ss;
+    ss << "MealyMachine::emitCpp - " << name << " is not C++ identifier";
+    throw ex::Exception(ss.str());
+  }
+  if (_compiledNoMove())
+    throw ex::Exception(
+        "MealyMachine::emitCpp - programs with noMove are not supported");
+  auto const& compiled  = _definition->compiled;
+  auto const  nofStates = compiled.nofStates;
+  Emitter     e(out, nonexistingCompiledState, noCompiledAction);
+
+  e.line(0, "// This file was generated by MealyMachine::emitCpp.");
+  e.line(0, "#pragma once");
+  e.line(0, "");
+  e.line(0, "#include <cstddef>");
+  e.line(0, "#include <cstdint>");
+  e.line(0, "");
+  e.line(0, "/**");
+  e.line(0, " * @brief This class is direct coded scanner of Mealy machine.");
+  e.line(0, " * Actions is called with action id and this scanner, it can");
+  e.line(0, " * call dontMove. position is position of current symbol.");
+  e.line(0, " */");
+  e.line(0, "struct " + name + " {");
+  e.line(1, "struct NoActions {");
+  e.line(2, "void operator()(uint32_t, " + name + "*) {}");
+  e.line(1, "};");
+  e.line(1, "uint32_t state     = 0;");
+  e.line(1, "size_t   position  = 0;");
+  e.line(1, "bool     _dontMove = false;");
+  e.line(1, "void begin() {");
+  e.line(2, "state    = 0;");
+  e.line(2, "position = 0;");
+  e.line(1, "}");
+  e.line(1, "void dontMove() { _dontMove = true; }");
+  e.line(1, "template <typename Actions>");
+  e.line(1, "bool match(unsigned char const* data, size_t size, Actions& "
+            "actions) {");
+  e.line(2, "begin();");
+  e.line(2, "return parse(data, size, actions) && end(actions);");
+  e.line(1, "}");
+  e.line(1, "bool match(unsigned char const* data, size_t size) {");
+  e.line(2, "NoActions actions;");
+  e.line(2, "return match(data, size, actions);");
+  e.line(1, "}");
+
+  e.line(1, "template <typename Actions>");
+  e.line(1, "bool end(Actions& actions) {");
+  e.line(2, "(void)actions;");
+  e.line(2, "switch (state) {");
+  for (size_t s = 0; s < nofStates; ++s) {
+    auto const& t = compiled.eofTransitions[s];
+    if (t.state == nonexistingCompiledState) continue;
+    e.line(3, "case " + std::to_string(s) + "u:");
+    if (t.action != noCompiledAction)
+      e.line(4, "actions(" + std::to_string(t.action) + "u, this);");
+    e.line(4, "return true;");
+  }
+  e.line(3, "default:");
+  e.line(4, "return false;");
+  e.line(2, "}");
+  e.line(1, "}");
+
+  e.line(1, "template <typename Actions>");
+  e.line(1, "bool parse(unsigned char const* data, size_t size, Actions& "
+            "actions) {");
+  e.line(2, "(void)actions;");
+  e.line(2, "unsigned char const*       p    = data;");
+  e.line(2, "unsigned char const* const end  = data + size;");
+  e.line(2, "size_t const               base = position;");
+  e.line(0, "#if defined(__GNUC__)");
+  e.line(2, "static void* const states[] = {");
+  for (size_t s = 0; s < nofStates; ++s)
+    e.line(3, "&&s" + std::to_string(s) + ",");
+  e.line(2, "};");
+  e.line(2, "goto* states[state];");
+  e.line(0, "#else");
+  e.line(2, "switch (state) {");
+  for (size_t s = 0; s < nofStates; ++s)
+    e.line(3, "case " + std::to_string(s) + "u: goto s" + std::to_string(s) +
+                  ";");
+  e.line(3, "default: return false;");
+  e.line(2, "}");
+  e.line(0, "#endif");
+
+  std::vector<Run> runs;
+  for (uint32_t s = 0; s < nofStates; ++s) {
+    runs.clear();
+    auto const* row = compiled.transitions + s * compiled.nofClasses;
+    for (uint32_t symbol = 0; symbol < compiledSymbols; ++symbol) {
+      auto const& t = row[compiled.classes[symbol]];
+      if (!runs.empty() && runs.back().state == t.state &&
+          runs.back().action == t.action)
+        runs.back().hi = symbol;
+      else
+        runs.push_back({symbol, symbol, t.state, t.action});
+    }
+    e.line(1, "s" + std::to_string(s) + ":");
+    e.line(2, "if (p == end) {");
+    e.line(3, "state = " + std::to_string(s) + ";");
+    e.position(3);
+    e.line(3, "return true;");
+    e.line(2, "}");
+    if (runs.size() == 1) {
+      e.transition(2, s, runs.front());
+      continue;
+    }
+    e.line(2, "{");
+    e.line(3, "unsigned const c = *p;");
+    e.runs(3, s, runs, 0, runs.size());
+    e.line(2, "}");
+  }
+  e.line(1, "}");
+  e.line(0, "};");
+}
@@ -5,8 +5,22 @@
 namespace mealyMachine{
   class TransitionChooser;
   class MealyMachine;
+  class Cursor;
   template<size_t>
   class MapTransitionChooser;
+  class ArrayTransitionChooser;
+  template<size_t>
+  class IntervalTransitionChooser;
+  template<size_t>
+  class HashTransitionChooser;
+  class ThreadPool;
+  class AhoCorasickBuilder;
+  template<size_t,size_t>
+  class StaticMealyMachine;
+  template<size_t>
+  class StaticMealyMachineBuilder;
+  template<typename>
+  class BasicMealyMachine;
   namespace ex{
     class Exception;
     class ParsingError;
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <MealyMachine/TransitionChooser.h>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/**
+ * @brief This class represents transition chooser for multi byte symbols.
+ * Symbol is loaded as fixed-width integer, hashed and looked up in open
+ * addressing table with linear probing that is kept at most half full.
+ * Later transitions override earlier ones with the same symbol.
+ */
+template <size_t N>
+class mealyMachine::HashTransitionChooser
+    : public mealyMachine::TransitionChooser {
+  static_assert(N == 1 || N == 2 || N == 4 || N == 8,
+                "HashTransitionChooser supports 1, 2, 4 and 8 byte symbols");
+
+ public:
+  HashTransitionChooser() : TransitionChooser(N) { _resize(16); }
+  virtual ~HashTransitionChooser() override {
+    for (auto& x : _keys) delete[] x;
+  }
+  virtual MealyMachine::TransitionIndex getTransition(
+      MealyMachine::TransitionSymbol const& data) const override {
+    auto const key = _load(data);
+    for (size_t i = _hash(key);; i = (i + 1) & _mask) {
+      auto const& slot = _slots[i];
+      if (slot.key == key) return slot.transition;
+      if (slot.transition == MealyMachine::nonexistingTransition)
+        return MealyMachine::nonexistingTransition;
+    }
+  }
+  virtual bool addTransition(
+      MealyMachine::TransitionSymbol const& data) override {
+    auto key = new MealyMachine::BasicUnit[N];
+    std::memcpy(key, data, N * sizeof(MealyMachine::BasicUnit));
+    _keys.push_back(key);
+    if (_size * 2 >= _slots.size()) _resize(_slots.size() * 2);
+    _insert(_load(data), _keys.size() - 1);
+    return true;
+  }
+  virtual MealyMachine::TransitionSymbol const& getSymbol(
+      MealyMachine::TransitionIndex const& i) const override {
+    return _keys.at(i);
+  }
+
+ protected:
+  using Key = typename std::conditional<
+      N == 1, uint8_t,
+      typename std::conditional<
+          N == 2, uint16_t,
+          typename std::conditional<N == 4, uint32_t, uint64_t>::type>::type>::
+      type;
+  struct Slot {
+    Key                           key;
+    MealyMachine::TransitionIndex transition;
+  };
+  static Key _load(MealyMachine::TransitionSymbol const& data) {
+    Key key;
+    std::memcpy(&key, data, sizeof(Key));
+    return key;
+  }
+  size_t _hash(Key const& key) const {
+    return static_cast<size_t>((static_cast<uint64_t>(key) *
+                                UINT64_C(0x9e3779b97f4a7c15)) >>
+                               _shift);
+  }
+  void _insert(Key const& key, MealyMachine::TransitionIndex const& id) {
+    for (size_t i = _hash(key);; i = (i + 1) & _mask) {
+      auto& slot = _slots[i];
+      if (slot.transition == MealyMachine::nonexistingTransition) {
+        slot = Slot{key, id};
+        _size++;
+        return;
+      }
+      if (slot.key == key) {
+        slot.transition = id;
+        return;
+      }
+    }
+  }
+  void _resize(size_t size) {
+    std::vector<Slot> old;
+    old.swap(_slots);
+    _slots.assign(size, Slot{0, MealyMachine::nonexistingTransition});
+    _mask  = size - 1;
+    _shift = 64;
+    while (size > 1) {
+      size >>= 1;
+      _shift--;
+    }
+    _size = 0;
+    for (auto const& slot : old)
+      if (slot.transition != MealyMachine::nonexistingTransition)
+        _insert(slot.key, slot.transition);
+  }
+  std::vector<MealyMachine::TransitionSymbol> _keys;
+  std::vector<Slot>                           _slots;
+  size_t                                      _size  = 0;
+  size_t                                      _mask  = 0;
+  unsigned                                    _shift = 64;
+};
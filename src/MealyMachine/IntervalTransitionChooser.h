@@ -0,0 +1,110 @@
+#pragma once
+
+#include <MealyMachine/TransitionChooser.h>
+#include <algorithm>
+#include <cstdint>
+
+/**
+ * @brief This class represents transition chooser that stores ranges of
+ * symbols natively.
+ * Symbols are compared as unsigned integers with the first byte being the
+ * least significant one, which is the order used by range transitions.
+ * Transitions are kept as sorted disjoint intervals and lookup is binary
+ * search, so memory and time depend on the number of ranges, not symbols.
+ * Later transitions override earlier ones where they overlap.
+ */
+template <size_t N>
+class mealyMachine::IntervalTransitionChooser
+    : public mealyMachine::TransitionChooser {
+  static_assert(N > 0 && N <= sizeof(uint64_t),
+                "IntervalTransitionChooser supports 1 to 8 byte symbols");
+
+ public:
+  IntervalTransitionChooser() : TransitionChooser(N) {}
+  virtual ~IntervalTransitionChooser() override {
+    for (auto& x : _keys) delete[] x;
+    for (auto& x : _lastKeys) delete[] x;
+  }
+  virtual MealyMachine::TransitionIndex getTransition(
+      MealyMachine::TransitionSymbol const& data) const override {
+    auto const key = _toKey(data);
+    auto ii = std::upper_bound(
+        _intervals.begin(), _intervals.end(), key,
+        [](uint64_t const& k, Interval const& i) { return k < i.from; });
+    if (ii == _intervals.begin()) return MealyMachine::nonexistingTransition;
+    --ii;
+    if (key > ii->to) return MealyMachine::nonexistingTransition;
+    return ii->transition;
+  }
+  virtual bool addTransition(
+      MealyMachine::TransitionSymbol const& data) override {
+    return addTransitionRange(data, data);
+  }
+  virtual bool addTransitionRange(
+      MealyMachine::TransitionSymbol const& from,
+      MealyMachine::TransitionSymbol const& to) override {
+    auto const id = _keys.size();
+    _keys.push_back(_copyKey(from));
+    _lastKeys.push_back(_copyKey(to));
+    _insert(Interval{_toKey(from), _toKey(to), id});
+    return true;
+  }
+  virtual MealyMachine::TransitionSymbol const& getSymbol(
+      MealyMachine::TransitionIndex const& i) const override {
+    return _keys.at(i);
+  }
+  virtual MealyMachine::TransitionSymbol const& getLastSymbol(
+      MealyMachine::TransitionIndex const& i) const override {
+    return _lastKeys.at(i);
+  }
+
+ protected:
+  struct Interval {
+    uint64_t                      from;
+    uint64_t                      to;
+    MealyMachine::TransitionIndex transition;
+  };
+  static uint64_t _toKey(MealyMachine::TransitionSymbol const& data) {
+    uint64_t key = 0;
+    for (size_t i = N; i > 0; --i) key = (key << 8) | data[i - 1];
+    return key;
+  }
+  MealyMachine::TransitionSymbol _copyKey(
+      MealyMachine::TransitionSymbol const& data) {
+    auto key = new MealyMachine::BasicUnit[N];
+    std::copy(data, data + N, key);
+    return key;
+  }
+  // intervals overlapped by the new one are replaced in place by the new
+  // interval and remnants of the first and the last overlapped interval
+  void _insert(Interval const& interval) {
+    auto const first = std::lower_bound(
+        _intervals.begin(), _intervals.end(), interval.from,
+        [](Interval const& i, uint64_t const& k) { return i.to < k; });
+    auto const last = std::upper_bound(
+        first, _intervals.end(), interval.to,
+        [](uint64_t const& k, Interval const& i) { return k < i.from; });
+    Interval parts[3];
+    size_t   nofParts = 0;
+    if (first != last && first->from < interval.from)
+      parts[nofParts++] =
+          Interval{first->from, interval.from - 1, first->transition};
+    parts[nofParts++] = interval;
+    if (first != last && (last - 1)->to > interval.to)
+      parts[nofParts++] =
+          Interval{interval.to + 1, (last - 1)->to, (last - 1)->transition};
+    auto const overlapped = static_cast<size_t>(last - first);
+    auto const at         = first - _intervals.begin();
+    auto const kept       = std::min(overlapped, nofParts);
+    std::copy(parts, parts + kept, _intervals.begin() + at);
+    if (overlapped > nofParts)
+      _intervals.erase(_intervals.begin() + at + nofParts,
+                       _intervals.begin() + at + overlapped);
+    else
+      _intervals.insert(_intervals.begin() + at + kept, parts + kept,
+                        parts + nofParts);
+  }
+  std::vector<MealyMachine::TransitionSymbol> _keys;
+  std::vector<MealyMachine::TransitionSymbol> _lastKeys;
+  std::vector<Interval>                       _intervals;
+};
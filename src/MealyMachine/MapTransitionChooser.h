@@ -25,7 +25,7 @@ class mealyMachine::MapTransitionChooser
     std::memcpy(key, data, N * sizeof(MealyMachine::BasicUnit));
     _keys.push_back(key);
 
-    auto id = _translator.size();
+    auto id = _keys.size() - 1;
     _translator[(MealyMachine::BasicUnit const*)_keys.back()] = id;
     return true;
   }
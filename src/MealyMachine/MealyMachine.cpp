@@ -5,10 +5,23 @@
 #include <iomanip>
 #include <iostream>
 #include <limits>
+#include <map>
 #include <sstream>
+#include <thread>
 
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MEALYMACHINE_SSE2
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include <MealyMachine/ArrayTransitionChooser.h>
 #include <MealyMachine/MapTransitionChooser.h>
 #include <MealyMachine/MealyMachine.h>
+#include <MealyMachine/ThreadPool.h>
 #include <MealyMachine/TransitionChooser.h>
 #include <MealyMachine/Exception.h>
 
@@ -23,15 +36,271 @@ std::string getHexRepresentation(MealyMachine::TransitionSymbol const& symbol,
   return ss.str();
 }
 
-MealyMachine::MealyMachine(size_t largestState) {
+namespace {
+
+inline size_t firstSetBit(uint32_t bits) {
+#if defined(__GNUC__)
+  return static_cast<size_t>(__builtin_ctz(bits));
+#else
+  size_t offset = 0;
+  while (!((bits >> offset) & 1u)) offset++;
+  return offset;
+#endif
+}
+
+using Range = uint8_t[2];
+
+#if defined(__AVX2__)
+/**
+ * @brief This function skips symbols that lie in at most 4 ranges,
+ * 32 symbols at a time.
+ *
+ * @return position of first symbol outside ranges or position of the first
+ * symbol that was not tested
+ */
+size_t skipRangesAvx2(Range const*                   ranges,
+                      size_t                         nofRanges,
+                      MealyMachine::BasicUnit const* data,
+                      size_t                         read,
+                      size_t                         size) {
+  __m256i from[4];
+  __m256i width[4];
+  for (size_t r = 0; r < nofRanges; ++r) {
+    from[r]  = _mm256_set1_epi8(static_cast<char>(ranges[r][0]));
+    width[r] = _mm256_set1_epi8(static_cast<char>(ranges[r][1] - ranges[r][0]));
+  }
+  auto const zero = _mm256_setzero_si256();
+  for (; read + 32 <= size; read += 32) {
+    auto const symbols =
+        _mm256_loadu_si256(reinterpret_cast<__m256i const*>(data + read));
+    auto stay = zero;
+    for (size_t r = 0; r < nofRanges; ++r) {
+      auto const outside =
+          _mm256_subs_epu8(_mm256_sub_epi8(symbols, from[r]), width[r]);
+      stay = _mm256_or_si256(stay, _mm256_cmpeq_epi8(outside, zero));
+    }
+    auto const leave = ~static_cast<uint32_t>(_mm256_movemask_epi8(stay));
+    if (leave) return read + firstSetBit(leave);
+  }
+  return read;
+}
+#endif
+
+#if defined(MEALYMACHINE_SSE2)
+/**
+ * @brief This function skips symbols that lie in at most 4 ranges,
+ * 16 symbols at a time.
+ *
+ * @return position of first symbol outside ranges or position of the first
+ * symbol that was not tested
+ */
+size_t skipRangesSse2(Range const*                   ranges,
+                      size_t                         nofRanges,
+                      MealyMachine::BasicUnit const* data,
+                      size_t                         read,
+                      size_t                         size) {
+  __m128i from[4];
+  __m128i width[4];
+  for (size_t r = 0; r < nofRanges; ++r) {
+    from[r]  = _mm_set1_epi8(static_cast<char>(ranges[r][0]));
+    width[r] = _mm_set1_epi8(static_cast<char>(ranges[r][1] - ranges[r][0]));
+  }
+  auto const zero = _mm_setzero_si128();
+  for (; read + 16 <= size; read += 16) {
+    auto const symbols =
+        _mm_loadu_si128(reinterpret_cast<__m128i const*>(data + read));
+    auto stay = zero;
+    for (size_t r = 0; r < nofRanges; ++r) {
+      auto const outside =
+          _mm_subs_epu8(_mm_sub_epi8(symbols, from[r]), width[r]);
+      stay = _mm_or_si128(stay, _mm_cmpeq_epi8(outside, zero));
+    }
+    auto const leave =
+        ~static_cast<uint32_t>(_mm_movemask_epi8(stay)) & 0xffffu;
+    if (leave) return read + firstSetBit(leave);
+  }
+  return read;
+}
+#endif
+
+}  // namespace
+
+MealyMachine::MealyMachine(size_t largestState)
+    : _editable(std::make_shared<Definition>()) {
+  _definition = _editable;
   _symbolBuffer.resize(largestState);
 }
 
+MealyMachine::MealyMachine(std::shared_ptr<Definition const> const& definition,
+                           size_t largestState)
+    : _definition(definition) {
+  _symbolBuffer.resize(largestState);
+}
+
+MealyMachine::MealyMachine(MealyMachine&&) noexcept = default;
+
+MealyMachine& MealyMachine::operator=(MealyMachine&&) noexcept = default;
+
 MealyMachine::~MealyMachine() {}
 
-inline void MealyMachine::_call(Transition const& transition) {
-  auto clb = std::get<CALLBACK>(transition);
-  if (clb) clb(this);
+Cursor::Cursor(MealyMachine const& machine)
+    : MealyMachine(machine._definition, machine._symbolBuffer.size()) {
+  _quiet        = machine._quiet;
+  _deferred     = machine._deferred;
+  _maxLookahead = machine._maxLookahead;
+  begin();
+}
+
+/**
+ * @brief This structure is stored inside callbacks created by token().
+ * The machine recognizes it when the callback is added and applies the
+ * marks itself, operator() is used only if the callback is called directly.
+ */
+struct MealyMachine::TokenCallback {
+  uint8_t  marks;
+  uint32_t kind;
+  uint32_t afterKind;
+  Callback callback;
+  void     operator()(MealyMachine* machine) const {
+    machine->_emitTokens(marks, kind, afterKind, machine->_readingPosition,
+                         machine->_currentSymbolSize);
+    if (callback) callback(machine);
+  }
+};
+
+/**
+ * @brief This structure is stored inside callbacks created by program().
+ * The machine recognizes it when the callback is added and stores the
+ * instructions into definition, operator() is used only if the callback is
+ * called directly.
+ */
+struct MealyMachine::ProgramCallback {
+  std::vector<Instruction> instructions;
+  Callback                 callback;
+  void                     operator()(MealyMachine* machine) const {
+    machine->_reserveSlots(instructions);
+    machine->_execute(instructions.data(), instructions.size(),
+                      machine->_readingPosition);
+    if (callback) callback(machine);
+  }
+};
+
+uint32_t MealyMachine::_reserveSlots(
+    std::vector<Instruction> const& program) {
+  uint32_t nofSlots = 0;
+  for (auto const& instruction : program) {
+    if (instruction.opcode != OP_INC && instruction.opcode != OP_MARK)
+      continue;
+    if (instruction.operand >= maxSlots) {
+      std::stringstream ss;
+      ss << "MealyMachine::program - slot " << instruction.operand;
+      ss << " is not less than " << maxSlots;
+      throw ex::Exception(ss.str());
+    }
+    nofSlots = std::max(nofSlots, instruction.operand + 1);
+  }
+  if (_slots.size() < nofSlots) _slots.resize(nofSlots, 0);
+  return nofSlots;
+}
+
+/**
+ * @brief This function returns true if any cell of compiled table uses
+ * program with noMove.
+ * Cursors that ignore programs cannot parse such machine.
+ *
+ * @return true if noMove is left in compiled table
+ */
+bool MealyMachine::_compiledNoMove() const {
+  auto const& compiled = _definition->compiled;
+  auto const& actions  = _definition->actions;
+  auto const& code     = _definition->code;
+  auto const  nofCells = compiled.nofStates * compiled.nofClasses;
+  auto const  noMove   = [&](uint32_t action) {
+    if (action == noCompiledAction) return false;
+    auto const& a = actions[action];
+    for (uint32_t i = 0; i < a.codeSize; ++i)
+      if (code[a.codeBegin + i].opcode == OP_NO_MOVE) return true;
+    return false;
+  };
+  for (size_t i = 0; i < nofCells; ++i)
+    if (noMove(compiled.transitions[i].action)) return true;
+  return false;
+}
+
+inline void MealyMachine::_execute(Instruction const* code,
+                                   size_t             size,
+                                   size_t             position) {
+  for (size_t i = 0; i < size; ++i) {
+    auto const operand = code[i].operand;
+    switch (code[i].opcode) {
+      case OP_INC:
+        assert(operand < _slots.size());
+        _slots[operand]++;
+        break;
+      case OP_MARK:
+        assert(operand < _slots.size());
+        _slots[operand] = position;
+        break;
+      case OP_NO_MOVE:
+        _dontMove = true;
+        break;
+      case OP_EMIT:
+        _emitToken({_tokenBegin, position, operand});
+        break;
+    }
+  }
+}
+
+inline void MealyMachine::_call(ActionIndex const& action) {
+  if (action == noCompiledAction) return;
+  auto const& a = _definition->actions[action];
+  if (a.tokenMarks)
+    _emitTokens(a.tokenMarks, a.tokenKind, a.tokenAfterKind, _readingPosition,
+                _currentSymbolSize);
+  if (a.codeSize)
+    _execute(_definition->code.data() + a.codeBegin, a.codeSize,
+             _readingPosition);
+  if (!a.callback) return;
+  if (_deferred) {
+    _actionLog.push_back({static_cast<uint32_t>(action),
+                          static_cast<uint32_t>(_currentState),
+                          _readingPosition});
+    return;
+  }
+  a.callback(this);
+}
+
+void MealyMachine::_emitTokens(uint8_t  marks,
+                               uint32_t kind,
+                               uint32_t afterKind,
+                               size_t   position,
+                               size_t   symbolSize) {
+  if (marks & TOKEN_END) _emitToken({_tokenBegin, position, kind});
+  if (marks & TOKEN_BEGIN) _tokenBegin = position;
+  if (marks & TOKEN_END_AFTER)
+    _emitToken({_tokenBegin, position + symbolSize, afterKind});
+}
+
+void MealyMachine::_emitToken(TokenRecord const& token) {
+  if (_nofTokens == _tokenCapacity) {
+    std::stringstream ss;
+    ss << "MealyMachine::_emitToken - ";
+    ss << "token buffer is full at position: " << token.end;
+    throw ex::Exception(ss.str());
+  }
+  _tokens[_nofTokens++] = token;
+}
+
+bool MealyMachine::_noTransition() {
+  if (_quiet) return false;
+  std::stringstream ss;
+  ss << "MealyMachine::_nextState - ";
+  ss << "there is no suitable transition from state ";
+  ss << _currentState << " using symbol: 0x"
+     << getHexRepresentation(_currentSymbol, _currentSymbolSize);
+  ss << " at position: " << _readingPosition;
+  throw ex::Exception(ss.str());
+  return false;
 }
 
 inline bool MealyMachine::_nextState(State const& state) {
@@ -39,26 +308,143 @@ inline bool MealyMachine::_nextState(State const& state) {
       std::get<CHOOSER>(state)->getTransition(_currentSymbol);
   Transition const* transition = nullptr;
   if (transitionIndex == MealyMachine::nonexistingTransition) {
-    auto trans = std::get<ELSE_TRANSITION>(state);
-    if (!trans) {
-      if (_quiet) return false;
-      std::stringstream ss;
-      ss << "MealyMachine::_nextState - ";
-      ss << "there is no suitable transition from state ";
-      ss << _currentState << " using symbol: 0x"
-         << getHexRepresentation(_currentSymbol, _currentSymbolSize);
-      ss << " at position: " << _currentSymbol;
-      throw ex::Exception(ss.str());
-      return false;
-    }
+    auto const& trans = std::get<ELSE_TRANSITION>(state);
+    if (!trans) return _noTransition();
     transition = &*trans;
   } else
     transition = &std::get<TRANSITIONS>(state)[transitionIndex];
-  _call(*transition);
+  _call(std::get<ACTION>(*transition));
   _currentState = std::get<STATE_INDEX>(*transition);
   return true;
 }
 
+MealyMachine::ActionIndex MealyMachine::_addAction(Callback const& callback) {
+  if (!callback) return noCompiledAction;
+  Action action;
+  action.callback = callback;
+  // token and program callbacks can be nested in each other
+  while (action.callback) {
+    if (auto const* token = action.callback.target<TokenCallback>()) {
+      if (action.tokenMarks) break;
+      action.tokenMarks = token->marks;
+      action.tokenKind      = token->kind;
+      action.tokenAfterKind = token->afterKind;
+      action.callback       = Callback(token->callback);
+      continue;
+    }
+    if (auto const* program = action.callback.target<ProgramCallback>()) {
+      if (action.codeSize) break;
+      auto const slots = _reserveSlots(program->instructions);
+      auto&      code  = _editable->code;
+      _editable->nofSlots = std::max(_editable->nofSlots, slots);
+      action.codeBegin = static_cast<uint32_t>(code.size());
+      action.codeSize  = static_cast<uint32_t>(program->instructions.size());
+      code.insert(code.end(), program->instructions.begin(),
+                  program->instructions.end());
+      action.callback = Callback(program->callback);
+      continue;
+    }
+    break;
+  }
+  auto id = _editable->actions.size();
+  _editable->actions.push_back(action);
+  return id;
+}
+
+void MealyMachine::_throwIfNotCompiled(std::string const& where) const {
+  if (isCompiled()) return;
+  std::stringstream ss;
+  ss << "MealyMachine::" << where;
+  ss << " - Mealy machine has to be compiled";
+  throw ex::Exception(ss.str());
+}
+
+MealyMachine::Callback MealyMachine::token(uint8_t         marks,
+                                           uint32_t        kind,
+                                           Callback const& callback) {
+  return TokenCallback{marks, kind, kind, callback};
+}
+
+MealyMachine::Callback MealyMachine::token(uint8_t         marks,
+                                           uint32_t        endKind,
+                                           uint32_t        afterKind,
+                                           Callback const& callback) {
+  return TokenCallback{marks, endKind, afterKind, callback};
+}
+
+MealyMachine::Instruction MealyMachine::inc(uint32_t slot) {
+  return {OP_INC, slot};
+}
+
+MealyMachine::Instruction MealyMachine::mark(uint32_t slot) {
+  return {OP_MARK, slot};
+}
+
+MealyMachine::Instruction MealyMachine::noMove() { return {OP_NO_MOVE, 0}; }
+
+MealyMachine::Instruction MealyMachine::emit(uint32_t kind) {
+  return {OP_EMIT, kind};
+}
+
+MealyMachine::Callback MealyMachine::program(
+    std::vector<Instruction> const& instructions,
+    Callback const&                 callback) {
+  return ProgramCallback{instructions, callback};
+}
+
+MealyMachine::Callback MealyMachine::nonConsuming(Callback const& callback) {
+  auto const* p = callback.target<ProgramCallback>();
+  if (!p) return program({noMove()}, callback);
+  auto instructions = p->instructions;
+  instructions.push_back(noMove());
+  return program(instructions, p->callback);
+}
+
+size_t MealyMachine::getSlot(size_t slot) const {
+  if (slot >= _slots.size()) return 0;
+  return _slots[slot];
+}
+
+void MealyMachine::clearSlots() {
+  std::fill(_slots.begin(), _slots.end(), 0);
+}
+
+void MealyMachine::setTokenBuffer(TokenRecord* buffer, size_t capacity) {
+  _tokens        = buffer;
+  _tokenCapacity = capacity;
+  _nofTokens     = 0;
+}
+
+size_t MealyMachine::getNofTokens() const { return _nofTokens; }
+
+void MealyMachine::clearTokens() { _nofTokens = 0; }
+
+/**
+ * @brief This function returns definition that can be modified.
+ * It throws if this is a cursor.
+ *
+ * @param where name of the modifying function
+ *
+ * @return definition of the machine
+ */
+MealyMachine::Definition& MealyMachine::_edit(std::string const& where) {
+  if (!_editable) {
+    std::stringstream ss;
+    ss << "MealyMachine::" << where;
+    ss << " - cursor cannot modify Mealy machine";
+    throw ex::Exception(ss.str());
+  }
+  return *_editable;
+}
+
+void MealyMachine::_throwIfCompiled(std::string const& where) const {
+  if (!isCompiled()) return;
+  std::stringstream ss;
+  ss << "MealyMachine::" << where;
+  ss << " - Mealy machine is compiled and cannot be modified";
+  throw ex::Exception(ss.str());
+}
+
 /**
  * @brief This function adds state to Mealy machine.
  *
@@ -70,6 +456,8 @@ inline bool MealyMachine::_nextState(State const& state) {
 MealyMachine::StateIndex MealyMachine::addState(
     std::shared_ptr<TransitionChooser> const& chooser,
     std::string const&                        name) {
+  auto& definition = _edit("addState(" + name + ")");
+  _throwIfCompiled("addState(" + name + ")");
   if (chooser == nullptr) {
     std::stringstream ss;
     ss << "MealyMachine::addState(" << name << ")";
@@ -86,20 +474,21 @@ MealyMachine::StateIndex MealyMachine::addState(
     throw ex::Exception(ss.str());
   }
 
-  auto id = _states.size();
-  _states.emplace_back(TransitionVector(), chooser, nullptr, nullptr, name);
+  auto id = definition.states.size();
+  definition.states.emplace_back(TransitionVector(), chooser, nullptr,
+                                   nullptr, name);
   return id;
 }
 
 MealyMachine::StateIndex MealyMachine::addState(std::string const& name) {
-  return addState(std::make_shared<MapTransitionChooser<1>>(), name);
+  return addState(std::make_shared<ArrayTransitionChooser>(), name);
 }
 
-void MealyMachine::addTransition(StateIndex const&       from,
-                                 TransitionSymbol const& lex,
-                                 StateIndex const&       to,
-                                 Callback const&         callback) {
-  if (from >= _states.size()) {
+void MealyMachine::_addTransition(StateIndex const&       from,
+                                  TransitionSymbol const& lex,
+                                  StateIndex const&       to,
+                                  ActionIndex const&      action) {
+  if (from >= _editable->states.size()) {
     std::stringstream ss;
     ss << "MealyMachine::addTransition(" << from << "," << lex << "," << to
        << ")";
@@ -107,18 +496,31 @@ void MealyMachine::addTransition(StateIndex const&       from,
     throw ex::Exception(ss.str());
   }
 
-  assert(from < _states.size());
-  assert(to < _states.size());
-  assert(std::get<CHOOSER>(_states[from]) != nullptr);
-  std::get<CHOOSER>(_states[from])->addTransition(lex);
-  std::get<TRANSITIONS>(_states[from]).push_back(Transition(to, callback));
+  assert(from < _editable->states.size());
+  assert(to < _editable->states.size());
+  assert(std::get<CHOOSER>(_editable->states[from]) != nullptr);
+  std::get<CHOOSER>(_editable->states[from])->addTransition(lex);
+  std::get<TRANSITIONS>(_editable->states[from])
+      .push_back(Transition(to, action));
+}
+
+void MealyMachine::addTransition(StateIndex const&       from,
+                                 TransitionSymbol const& lex,
+                                 StateIndex const&       to,
+                                 Callback const&         callback) {
+  _edit("addTransition");
+  _throwIfCompiled("addTransition");
+  _addTransition(from, lex, to, _addAction(callback));
 }
 
 void MealyMachine::addTransition(StateIndex const&                    from,
                                  std::vector<TransitionSymbol> const& symbols,
                                  StateIndex const&                    to,
                                  Callback const& callback) {
-  for (auto const& x : symbols) addTransition(from, x, to, callback);
+  _edit("addTransition");
+  _throwIfCompiled("addTransition");
+  auto action = _addAction(callback);
+  for (auto const& x : symbols) _addTransition(from, x, to, action);
 }
 
 void MealyMachine::addTransition(StateIndex const&       from,
@@ -126,40 +528,47 @@ void MealyMachine::addTransition(StateIndex const&       from,
                                  TransitionSymbol const& symbolTo,
                                  StateIndex const&       to,
                                  Callback const&         callback) {
-  assert(from < _states.size());
-  assert(std::get<CHOOSER>(_states.at(from)) != nullptr);
-  size_t stateSize = std::get<CHOOSER>(_states.at(from))->getSize();
-  for (size_t i = 1; i <= stateSize; ++i)
-    if (symbolFrom[stateSize - i] > symbolTo[stateSize - i]) return;
-  bool                   running = true;
-  std::vector<BasicUnit> currentSymbol;
-  currentSymbol.resize(stateSize);
-  std::memcpy(currentSymbol.data(), symbolFrom, stateSize);
-  do {
-    addTransition(from, currentSymbol.data(), to, callback);
+  auto& definition = _edit("addTransition");
+  _throwIfCompiled("addTransition");
+  assert(from < definition.states.size());
+  assert(std::get<CHOOSER>(definition.states.at(from)) != nullptr);
+  auto const& chooser   = std::get<CHOOSER>(definition.states.at(from));
+  size_t      stateSize = chooser->getSize();
+  // symbols are unsigned integers whose first byte is the least significant
+  auto const less = [stateSize](BasicUnit const* a, BasicUnit const* b) {
+    for (size_t i = stateSize; i > 0; --i)
+      if (a[i - 1] != b[i - 1]) return a[i - 1] < b[i - 1];
+    return false;
+  };
+  if (less(symbolTo, symbolFrom)) return;
+  if (chooser->addTransitionRange(symbolFrom, symbolTo)) {
+    assert(to < definition.states.size());
+    std::get<TRANSITIONS>(definition.states[from])
+        .push_back(Transition(to, _addAction(callback)));
+    return;
+  }
+  auto                   action = _addAction(callback);
+  std::vector<BasicUnit> currentSymbol(symbolFrom, symbolFrom + stateSize);
+  for (;;) {
+    _addTransition(from, currentSymbol.data(), to, action);
+    if (!less(currentSymbol.data(), symbolTo)) break;
+    // current symbol is less than symbolTo, so the carry stops in it
     size_t ii = 0;
-    while (ii < currentSymbol.size() &&
-           currentSymbol.at(ii) == std::numeric_limits<BasicUnit>::max())
-      currentSymbol.at(ii++) = 0;
-    if (ii < currentSymbol.size())
-      currentSymbol.at(ii)++;
-    else
-      break;
-    for (size_t i = 1; i <= stateSize; ++i)
-      if (currentSymbol[stateSize - i] > symbolTo[stateSize - i]) {
-        running = false;
-        break;
-      }
-  } while (running);
+    while (currentSymbol[ii] == std::numeric_limits<BasicUnit>::max())
+      currentSymbol[ii++] = 0;
+    currentSymbol[ii]++;
+  }
 }
 
 void MealyMachine::addTransition(StateIndex const&  from,
                                  std::string const& lex,
                                  StateIndex const&  to,
                                  Callback const&    callback) {
-  assert(from < _states.size());
-  assert(std::get<CHOOSER>(_states.at(from)) != nullptr);
-  size_t stateSize = std::get<CHOOSER>(_states.at(from))->getSize();
+  auto& definition = _edit("addTransition");
+  _throwIfCompiled("addTransition");
+  assert(from < definition.states.size());
+  assert(std::get<CHOOSER>(definition.states.at(from)) != nullptr);
+  size_t stateSize = std::get<CHOOSER>(definition.states.at(from))->getSize();
   if (lex.length() % stateSize != 0) {
     std::stringstream ss;
     ss << "MealyMachine::addTransition(";
@@ -169,8 +578,9 @@ void MealyMachine::addTransition(StateIndex const&  from,
     throw ex::Exception(ss.str());
     return;
   }
+  auto action = _addAction(callback);
   for (size_t offset = 0; offset < lex.length(); offset += stateSize)
-    addTransition(from, (TransitionSymbol)lex.c_str() + offset, to, callback);
+    _addTransition(from, (TransitionSymbol)lex.c_str() + offset, to, action);
 }
 
 void MealyMachine::addTransition(StateIndex const&               from,
@@ -192,29 +602,734 @@ void MealyMachine::addTransition(StateIndex const&  from,
 void MealyMachine::addElseTransition(StateIndex const& from,
                                      StateIndex const& to,
                                      Callback const&   callback) {
-  assert(from < _states.size());
-  assert(to < _states.size());
-  std::get<ELSE_TRANSITION>(_states[from]) =
-      std::make_shared<Transition>(to, callback);
+  auto& definition = _edit("addElseTransition");
+  _throwIfCompiled("addElseTransition");
+  assert(from < definition.states.size());
+  assert(to < definition.states.size());
+  std::get<ELSE_TRANSITION>(definition.states[from]) =
+      std::make_shared<Transition>(to, _addAction(callback));
 }
 
 void MealyMachine::addEOFTransition(StateIndex const& from,
                                     Callback const&   callback) {
-  assert(from < _states.size());
-  std::get<EOF_TRANSITION>(_states[from]) =
-      std::make_shared<Transition>(0, callback);
+  auto& definition = _edit("addEOFTransition");
+  _throwIfCompiled("addEOFTransition");
+  assert(from < definition.states.size());
+  std::get<EOF_TRANSITION>(definition.states[from]) =
+      std::make_shared<Transition>(0, _addAction(callback));
+}
+
+void MealyMachine::addCodepointRange(StateIndex const& from,
+                                     uint32_t          lo,
+                                     uint32_t          hi,
+                                     StateIndex const& to,
+                                     Callback const&   callback) {
+  addCodepointRanges(from, {{lo, hi}}, to, callback);
+}
+
+/**
+ * @brief This function adds UTF-8 byte sub-automaton of code point ranges.
+ * Code points of one encoded length form a tree of 64-ary blocks, every
+ * byte selects one block. Ranges are intersected with the block and shifted
+ * to its beginning; the relative ranges together with the number of
+ * remaining bytes identify the state that reads the rest of the sequence,
+ * so equal suffixes share one state.
+ */
+void MealyMachine::addCodepointRanges(StateIndex const&                  from,
+                                      std::vector<CodepointRange> const& ranges,
+                                      StateIndex const&                  to,
+                                      Callback const& callback) {
+  auto& definition = _edit("addCodepointRanges");
+  _throwIfCompiled("addCodepointRanges");
+  auto const maxCodepoint = uint32_t(0x10ffff);
+  if (from >= definition.states.size() ||
+      to >= definition.states.size() ||
+      std::get<CHOOSER>(definition.states[from])->getSize() != 1) {
+    std::stringstream ss;
+    ss << "MealyMachine::addCodepointRanges(" << from << ", " << to << ")";
+    ss << " - states have to exist and start state has to use 1 byte ";
+    ss << "transition chooser";
+    throw ex::Exception(ss.str());
+  }
+  for (auto const& range : ranges)
+    if (range.lo > range.hi || range.hi > maxCodepoint) {
+      std::stringstream ss;
+      ss << "MealyMachine::addCodepointRanges - invalid code point range [";
+      ss << range.lo << ", " << range.hi << "]";
+      throw ex::Exception(ss.str());
+    }
+
+  // sorted disjoint ranges without surrogates
+  auto sorted = ranges;
+  std::sort(sorted.begin(), sorted.end(),
+            [](CodepointRange const& a, CodepointRange const& b) {
+              return a.lo < b.lo;
+            });
+  std::vector<CodepointRange> normalized;
+  for (auto const& range : sorted) {
+    if (!normalized.empty() && range.lo <= normalized.back().hi + 1)
+      normalized.back().hi = std::max(normalized.back().hi, range.hi);
+    else
+      normalized.push_back(range);
+  }
+  auto const surrogateLo = uint32_t(0xd800);
+  auto const surrogateHi = uint32_t(0xdfff);
+  std::vector<CodepointRange> valid;
+  for (auto const& range : normalized) {
+    if (range.lo < surrogateLo)
+      valid.push_back({range.lo, std::min(range.hi, surrogateLo - 1)});
+    if (range.hi > surrogateHi)
+      valid.push_back({std::max(range.lo, surrogateHi + 1), range.hi});
+  }
+
+  auto const intersect = [](std::vector<CodepointRange> const& rs,
+                            uint32_t lo, uint32_t hi) {
+    std::vector<CodepointRange> result;
+    for (auto const& r : rs)
+      if (r.lo <= hi && r.hi >= lo)
+        result.push_back({std::max(r.lo, lo) - lo, std::min(r.hi, hi) - lo});
+    return result;
+  };
+
+  auto const action = _addAction(callback);
+  std::map<std::vector<uint32_t>, StateIndex> suffixes;
+  std::function<StateIndex(std::vector<CodepointRange> const&, size_t)> suffix;
+  // reads byte firstByte+k for every block k that intersects ranges
+  auto const branch = [&](StateIndex const&                  state,
+                          std::vector<CodepointRange> const& rs,
+                          size_t remaining, BasicUnit firstByte,
+                          size_t nofBytes) {
+    auto const blockSize = uint32_t(1) << (6 * remaining);
+    for (size_t k = 0; k < nofBytes; ++k) {
+      auto const lo    = uint32_t(k) * blockSize;
+      auto const child = intersect(rs, lo, lo + blockSize - 1);
+      if (child.empty()) continue;
+      BasicUnit const symbol = static_cast<BasicUnit>(firstByte + k);
+      if (remaining == 0)
+        _addTransition(state, &symbol, to, action);
+      else
+        _addTransition(state, &symbol, suffix(child, remaining),
+                       noCompiledAction);
+    }
+  };
+  suffix = [&](std::vector<CodepointRange> const& rs, size_t remaining) {
+    std::vector<uint32_t> key = {uint32_t(remaining)};
+    for (auto const& r : rs) {
+      key.push_back(r.lo);
+      key.push_back(r.hi);
+    }
+    auto it = suffixes.find(key);
+    if (it != suffixes.end()) return it->second;
+    auto const state = addState();
+    suffixes[key]    = state;
+    branch(state, rs, remaining - 1, 0x80, 64);
+    return state;
+  };
+
+  // lead bytes of 1, 2, 3 and 4 byte sequences, shorter encodings of
+  // the same code points (overlong) are cut off
+  auto const encodedIn = [&](uint32_t lo, uint32_t hi) {
+    auto result = intersect(valid, lo, hi);
+    for (auto& r : result) {
+      r.lo += lo;
+      r.hi += lo;
+    }
+    return result;
+  };
+  branch(from, encodedIn(0x0, 0x7f), 0, 0x00, 0x80);
+  branch(from, encodedIn(0x80, 0x7ff), 1, 0xc0, 0x20);
+  branch(from, encodedIn(0x800, 0xffff), 2, 0xe0, 0x10);
+  branch(from, encodedIn(0x10000, maxCodepoint), 3, 0xf0, 0x05);
+}
+
+void MealyMachine::compile() {
+  auto& definition = _edit("compile()");
+  _throwIfCompiled("compile()");
+  if (definition.states.size() >= nonexistingCompiledState ||
+      definition.actions.size() >= noCompiledAction) {
+    std::stringstream ss;
+    ss << "MealyMachine::compile() - ";
+    ss << "Mealy machine is too large to be compiled";
+    throw ex::Exception(ss.str());
+  }
+  for (size_t s = 0; s < definition.states.size(); ++s) {
+    auto const& chooser = std::get<CHOOSER>(definition.states[s]);
+    if (chooser->getSize() == 1) continue;
+    std::stringstream ss;
+    ss << "MealyMachine::compile() - ";
+    ss << "state " << s << " uses transition chooser with symbol size ";
+    ss << chooser->getSize() << ", only 1 byte symbols can be compiled";
+    throw ex::Exception(ss.str());
+  }
+
+  auto const nofStates = definition.states.size();
+  auto&      compiled  = definition.compiled;
+
+  // symbols are equivalent if they lead to the same cell in every state
+  std::vector<CompiledTransition> row(compiledSymbols);
+  std::vector<uint8_t>            classes(compiledSymbols, 0);
+  std::vector<uint8_t>            refined(compiledSymbols);
+  size_t                          nofClasses = 1;
+  std::vector<std::vector<std::pair<CompiledTransition, size_t>>> splits;
+  for (size_t s = 0; s < nofStates && nofClasses < compiledSymbols; ++s) {
+    _lowerState(s, row.data());
+    splits.assign(nofClasses, {});
+    size_t nofRefined = 0;
+    for (size_t symbol = 0; symbol < compiledSymbols; ++symbol) {
+      auto& split = splits[classes[symbol]];
+      auto  ii    = std::find_if(
+          split.begin(), split.end(),
+          [&](std::pair<CompiledTransition, size_t> const& p) {
+            return p.first.state == row[symbol].state &&
+                   p.first.action == row[symbol].action;
+          });
+      if (ii == split.end())
+        ii = split.emplace(split.end(), row[symbol], nofRefined++);
+      refined[symbol] = static_cast<uint8_t>(ii->second);
+    }
+    classes.swap(refined);
+    nofClasses = nofRefined;
+  }
+
+  auto& storage = compiled.storage;
+  storage.assign(
+      nofStates * nofClasses + nofStates,
+      CompiledTransition{nonexistingCompiledState, noCompiledAction});
+  for (size_t s = 0; s < nofStates; ++s) {
+    _lowerState(s, row.data());
+    for (size_t symbol = 0; symbol < compiledSymbols; ++symbol)
+      storage[s * nofClasses + classes[symbol]] = row[symbol];
+    auto const& eofTrans = std::get<EOF_TRANSITION>(definition.states[s]);
+    if (eofTrans)
+      storage[nofStates * nofClasses + s] = CompiledTransition{
+          0, static_cast<uint32_t>(std::get<ACTION>(*eofTrans))};
+  }
+  compiled.classStorage = classes;
+  compiled.acceptStorage.assign(nofStates, notAccepting);
+  std::copy(definition.accepting.begin(), definition.accepting.end(),
+            compiled.acceptStorage.begin());
+  compiled.accepting      = compiled.acceptStorage.data();
+  compiled.transitions    = storage.data();
+  compiled.eofTransitions = storage.data() + nofStates * nofClasses;
+  compiled.classes        = compiled.classStorage.data();
+  compiled.nofClasses     = nofClasses;
+  compiled.nofStates      = nofStates;
+  _collapseNonConsuming(compiled);
+  _compileLoops(compiled);
+}
+
+/**
+ * @brief This function replaces non-consuming cells by cells that the
+ * symbol reaches after the chain of non-consuming transitions.
+ * Action of the chain is known only if it has no user callback. Chain stops
+ * at user callback and at missing transition, cells of chains with cycles
+ * are not changed and no actions are merged for them; missing
+ * transition is collapsed only if the chain has no effects, so effects are
+ * not lost before the error.
+ * Merged actions are appended to actions, so ids of user actions do not
+ * change.
+ *
+ * @param compiled compiled table with transitions and symbol classes
+ */
+void MealyMachine::_collapseNonConsuming(CompiledTable& compiled) {
+  auto&      actions      = _editable->actions;
+  auto&      code         = _editable->code;
+  auto const nonConsuming = [&](uint32_t action) {
+    if (action == noCompiledAction) return false;
+    auto const& a = actions[action];
+    if (a.callback) return false;
+    for (uint32_t i = 0; i < a.codeSize; ++i)
+      if (code[a.codeBegin + i].opcode == OP_NO_MOVE) return true;
+    return false;
+  };
+  auto const noMoveOnly = [&](uint32_t action) {
+    auto const& a = actions[action];
+    if (a.tokenMarks) return false;
+    for (uint32_t i = 0; i < a.codeSize; ++i)
+      if (code[a.codeBegin + i].opcode != OP_NO_MOVE) return false;
+    return true;
+  };
+  auto const nofClasses = compiled.nofClasses;
+  auto const nofStates  = compiled.nofStates;
+  auto&      storage    = compiled.storage;
+  std::vector<CompiledTransition> const original(
+      storage.begin(), storage.begin() + nofStates * nofClasses);
+  std::map<std::pair<uint32_t, uint32_t>, uint32_t> merged;
+
+  // action "first" without noMove followed by action "second"
+  auto const merge = [&](uint32_t first, uint32_t second) {
+    auto const key = std::make_pair(first, second);
+    auto const ii  = merged.find(key);
+    if (ii != merged.end()) return ii->second;
+    Action const a = actions[first];
+    Action const b =
+        second == noCompiledAction ? Action() : actions[second];
+    std::vector<Instruction> program;
+    for (uint32_t i = 0; i < a.codeSize; ++i)
+      if (code[a.codeBegin + i].opcode != OP_NO_MOVE)
+        program.push_back(code[a.codeBegin + i]);
+    if (program.empty() && !a.tokenMarks) {
+      // noMove only, the cell of "to" state is used as it is
+      merged[key] = second;
+      return second;
+    }
+    // marks of merged action are applied before its program
+    if (b.callback || (b.tokenMarks && (a.tokenMarks || !program.empty())))
+      return noCompiledAction;
+    program.insert(program.end(), code.begin() + b.codeBegin,
+                   code.begin() + b.codeBegin + b.codeSize);
+    Action action;
+    auto const& marked    = a.tokenMarks ? a : b;
+    action.tokenMarks     = a.tokenMarks | b.tokenMarks;
+    action.tokenKind      = marked.tokenKind;
+    action.tokenAfterKind = marked.tokenAfterKind;
+    action.codeBegin  = static_cast<uint32_t>(code.size());
+    action.codeSize   = static_cast<uint32_t>(program.size());
+    code.insert(code.end(), program.begin(), program.end());
+    auto const id = static_cast<uint32_t>(actions.size());
+    actions.push_back(action);
+    merged[key] = id;
+    return id;
+  };
+
+  // chain that returns to one of its states is a cycle, the symbol would
+  // never be read, so the cell is kept as it is
+  std::vector<size_t> visited(nofStates, nofStates * nofClasses);
+  auto const cyclic = [&](size_t s, size_t c) {
+    auto const walk = s * nofClasses + c;
+    visited[s]      = walk;
+    for (auto cell = original[walk]; nonConsuming(cell.action);
+         cell      = original[cell.state * nofClasses + c]) {
+      if (cell.state == nonexistingCompiledState) return false;
+      if (visited[cell.state] == walk) return true;
+      visited[cell.state] = walk;
+    }
+    return false;
+  };
+
+  for (size_t s = 0; s < nofStates; ++s)
+    for (size_t c = 0; c < nofClasses; ++c) {
+      auto cell = original[s * nofClasses + c];
+      if (cyclic(s, c)) continue;
+      while (nonConsuming(cell.action)) {
+        auto const& next = original[cell.state * nofClasses + c];
+        if (next.state == nonexistingCompiledState) {
+          // noMove only, missing transition is reported in this state
+          if (noMoveOnly(cell.action)) cell = next;
+          break;
+        }
+        auto const action = merge(cell.action, next.action);
+        if (action == noCompiledAction && next.action != noCompiledAction)
+          break;
+        cell = {next.state, action};
+      }
+      storage[s * nofClasses + c] = cell;
+    }
+}
+
+/**
+ * @brief This function computes cells of one state for all 256 symbols.
+ *
+ * @param s state index
+ * @param row output row of compiledSymbols cells
+ */
+void MealyMachine::_lowerState(StateIndex const&   s,
+                               CompiledTransition* row) const {
+  auto lower = [](Transition const& t) {
+    return CompiledTransition{static_cast<uint32_t>(std::get<STATE_INDEX>(t)),
+                              static_cast<uint32_t>(std::get<ACTION>(t))};
+  };
+  auto const& state     = _definition->states[s];
+  auto const& chooser   = std::get<CHOOSER>(state);
+  auto const& elseTrans = std::get<ELSE_TRANSITION>(state);
+  for (size_t symbol = 0; symbol < compiledSymbols; ++symbol) {
+    auto const       unit  = static_cast<BasicUnit>(symbol);
+    TransitionSymbol input = &unit;
+    auto const       index = chooser->getTransition(input);
+    if (index != nonexistingTransition)
+      row[symbol] = lower(std::get<TRANSITIONS>(state)[index]);
+    else if (elseTrans)
+      row[symbol] = lower(*elseTrans);
+    else
+      row[symbol] =
+          CompiledTransition{nonexistingCompiledState, noCompiledAction};
+  }
+}
+
+/**
+ * @brief This function computes self-loop descriptions of compiled states.
+ *
+ * @param compiled compiled table with transitions and symbol classes
+ */
+void MealyMachine::_compileLoops(CompiledTable& compiled) {
+  auto& loops = compiled.loopStorage;
+  loops.resize(compiled.nofStates);
+  for (size_t s = 0; s < compiled.nofStates; ++s)
+    loops[s] = _computeLoop(compiled.transitions + s * compiled.nofClasses,
+                            compiled.classes, s);
+  compiled.loops = loops.data();
+}
+
+/**
+ * @brief This function skips symbols that keep state in its self-loop.
+ *
+ * @param loop description of the self-loop
+ * @param data input data
+ * @param read position of first symbol that has not been read
+ * @param size size of input data
+ *
+ * @return position of first symbol that leaves the self-loop or size
+ */
+size_t MealyMachine::_skipLoop(CompiledLoop const& loop,
+                               BasicUnit const*    data,
+                               size_t              read,
+                               size_t              size) {
+  if (loop.nofRanges != bitmapLoop) {
+#if defined(__AVX2__)
+    read = skipRangesAvx2(loop.ranges, loop.nofRanges, data, read, size);
+#endif
+#if defined(MEALYMACHINE_SSE2)
+    read = skipRangesSse2(loop.ranges, loop.nofRanges, data, read, size);
+#endif
+  }
+  while (read < size && ((loop.stay[data[read] / 8] >> (data[read] % 8)) & 1u))
+    ++read;
+  return read;
+}
+
+/**
+ * @brief This function merges symbol classes that have identical columns.
+ *
+ * @param compiled compiled table that owns its storage
+ */
+void MealyMachine::_mergeClasses(CompiledTable& compiled) {
+  auto const nofStates  = compiled.nofStates;
+  auto const nofClasses = compiled.nofClasses;
+  auto const pack       = [](CompiledTransition const& t) {
+    return (static_cast<uint64_t>(t.state) << 32) | t.action;
+  };
+  std::map<std::vector<uint64_t>, size_t> columns;
+  std::vector<size_t>                     merged(nofClasses);
+  std::vector<size_t>                     representatives;
+  std::vector<uint64_t>                   column(nofStates);
+  for (size_t c = 0; c < nofClasses; ++c) {
+    for (size_t s = 0; s < nofStates; ++s)
+      column[s] = pack(compiled.transitions[s * nofClasses + c]);
+    auto const inserted = columns.emplace(column, representatives.size());
+    if (inserted.second) representatives.push_back(c);
+    merged[c] = inserted.first->second;
+  }
+  if (representatives.size() == nofClasses) return;
+
+  auto const                      nofMerged = representatives.size();
+  std::vector<CompiledTransition> storage(nofStates * nofMerged + nofStates);
+  for (size_t s = 0; s < nofStates; ++s) {
+    for (size_t c = 0; c < nofMerged; ++c)
+      storage[s * nofMerged + c] =
+          compiled.transitions[s * nofClasses + representatives[c]];
+    storage[nofStates * nofMerged + s] = compiled.eofTransitions[s];
+  }
+  // classes of loaded and static machines are not owned by the table
+  if (compiled.classStorage.empty())
+    compiled.classStorage.assign(compiled.classes,
+                                 compiled.classes + compiledSymbols);
+  for (auto& c : compiled.classStorage)
+    c = static_cast<uint8_t>(merged[c]);
+  compiled.storage.swap(storage);
+  compiled.transitions    = compiled.storage.data();
+  compiled.eofTransitions = compiled.storage.data() + nofStates * nofMerged;
+  compiled.classes        = compiled.classStorage.data();
+  compiled.nofClasses     = nofMerged;
+}
+
+MealyMachine::MinimizationReport MealyMachine::minimize() {
+  auto& definition = _edit("minimize()");
+  if (!isCompiled()) compile();
+  auto&      compiled   = definition.compiled;
+  auto const nofStates  = compiled.nofStates;
+  auto const nofClasses = compiled.nofClasses;
+  // missing transitions lead to sink state
+  auto const sink = nofStates;
+  auto const size = nofStates + 1;
+  auto const next = [&](size_t s, size_t c) -> size_t {
+    if (s == sink) return sink;
+    auto const& t = compiled.transitions[s * nofClasses + c];
+    return t.state == nonexistingCompiledState ? sink : t.state;
+  };
+
+  // states are split by their callbacks and EOF transitions first
+  std::vector<size_t> blockOf(size);
+  {
+    std::map<std::vector<uint64_t>, size_t> outputs;
+    std::vector<uint64_t>                   output;
+    auto const pack = [](CompiledTransition const& t) {
+      uint64_t const exists = t.state != nonexistingCompiledState;
+      return (exists << 32) | t.action;
+    };
+    for (size_t s = 0; s < size; ++s) {
+      output.clear();
+      output.push_back(s != sink);
+      if (s != sink) {
+        output.push_back(compiled.accepting[s]);
+        output.push_back(pack(compiled.eofTransitions[s]));
+        for (size_t c = 0; c < nofClasses; ++c)
+          output.push_back(pack(compiled.transitions[s * nofClasses + c]));
+      }
+      blockOf[s] = outputs.emplace(output, outputs.size()).first->second;
+    }
+  }
+
+  // blocks are continuous ranges of elements, marked elements of a block
+  // are moved to the beginning of its range
+  std::vector<size_t> elements(size);
+  std::vector<size_t> location(size);
+  std::vector<size_t> first;
+  std::vector<size_t> end;
+  std::vector<size_t> marked;
+  for (size_t s = 0; s < size; ++s) {
+    if (blockOf[s] >= end.size()) end.resize(blockOf[s] + 1, 0);
+    end[blockOf[s]]++;
+  }
+  first.resize(end.size());
+  marked.assign(end.size(), 0);
+  for (size_t b = 0, offset = 0; b < end.size(); ++b) {
+    first[b] = offset;
+    offset += end[b];
+    end[b] = first[b];
+  }
+  for (size_t s = 0; s < size; ++s) {
+    location[s]             = end[blockOf[s]]++;
+    elements[location[s]]  = s;
+  }
+
+  // predecessors of every state for every symbol class
+  std::vector<size_t> predecessorOffsets(nofClasses * size + 1, 0);
+  std::vector<size_t> predecessors(nofClasses * size);
+  for (size_t c = 0; c < nofClasses; ++c)
+    for (size_t s = 0; s < size; ++s)
+      predecessorOffsets[c * size + next(s, c) + 1]++;
+  for (size_t i = 1; i < predecessorOffsets.size(); ++i)
+    predecessorOffsets[i] += predecessorOffsets[i - 1];
+  {
+    auto fill = predecessorOffsets;
+    for (size_t c = 0; c < nofClasses; ++c)
+      for (size_t s = 0; s < size; ++s)
+        predecessors[fill[c * size + next(s, c)]++] = s;
+  }
+
+  std::vector<std::pair<size_t, size_t>> work;
+  std::vector<char>                      inWork;
+  auto const addWork = [&](size_t b, size_t c) {
+    if (inWork.size() <= b * nofClasses + c)
+      inWork.resize((b + 1) * nofClasses, 0);
+    if (inWork[b * nofClasses + c]) return;
+    inWork[b * nofClasses + c] = 1;
+    work.emplace_back(b, c);
+  };
+  for (size_t b = 0; b < first.size(); ++b)
+    for (size_t c = 0; c < nofClasses; ++c) addWork(b, c);
+
+  std::vector<size_t> splitter;
+  std::vector<size_t> touched;
+  while (!work.empty()) {
+    auto const a = work.back().first;
+    auto const c = work.back().second;
+    work.pop_back();
+    inWork[a * nofClasses + c] = 0;
+    splitter.assign(elements.begin() + first[a], elements.begin() + end[a]);
+    for (auto const& t : splitter) {
+      for (auto i = predecessorOffsets[c * size + t];
+           i < predecessorOffsets[c * size + t + 1]; ++i) {
+        auto const p = predecessors[i];
+        auto const b = blockOf[p];
+        if (marked[b] == 0) touched.push_back(b);
+        auto const q = elements[first[b] + marked[b]];
+        std::swap(elements[location[p]], elements[first[b] + marked[b]]);
+        std::swap(location[p], location[q]);
+        marked[b]++;
+      }
+    }
+    for (auto const& b : touched) {
+      auto const m = marked[b];
+      marked[b]    = 0;
+      if (m == end[b] - first[b]) continue;
+      auto const nb = first.size();
+      first.push_back(first[b]);
+      end.push_back(first[b] + m);
+      marked.push_back(0);
+      first[b] += m;
+      for (auto i = first[nb]; i < end[nb]; ++i) blockOf[elements[i]] = nb;
+      for (size_t d = 0; d < nofClasses; ++d) {
+        if (inWork.size() > b * nofClasses + d && inWork[b * nofClasses + d])
+          addWork(nb, d);
+        else if (end[nb] - first[nb] < end[b] - first[b])
+          addWork(nb, d);
+        else
+          addWork(b, d);
+      }
+    }
+    touched.clear();
+  }
+
+  // reachable blocks become new states, start state stays 0
+  auto const          none = std::numeric_limits<size_t>::max();
+  std::vector<size_t> newState(first.size(), none);
+  std::vector<size_t> representatives;
+  newState[blockOf[0]] = 0;
+  representatives.push_back(elements[first[blockOf[0]]]);
+  for (size_t i = 0; i < representatives.size(); ++i)
+    for (size_t c = 0; c < nofClasses; ++c) {
+      auto const t = next(representatives[i], c);
+      if (t == sink || newState[blockOf[t]] != none) continue;
+      newState[blockOf[t]] = representatives.size();
+      representatives.push_back(elements[first[blockOf[t]]]);
+    }
+
+  auto const                      nofNewStates = representatives.size();
+  std::vector<CompiledTransition> storage(nofNewStates * nofClasses +
+                                          nofNewStates);
+  std::vector<uint32_t>           accepting(nofNewStates);
+  for (size_t s = 0; s < nofNewStates; ++s) {
+    auto const r = representatives[s];
+    accepting[s] = compiled.accepting[r];
+    for (size_t c = 0; c < nofClasses; ++c) {
+      auto t = compiled.transitions[r * nofClasses + c];
+      if (t.state != nonexistingCompiledState)
+        t.state = static_cast<uint32_t>(newState[blockOf[t.state]]);
+      storage[s * nofClasses + c] = t;
+    }
+    storage[nofNewStates * nofClasses + s] = compiled.eofTransitions[r];
+  }
+  compiled.storage.swap(storage);
+  compiled.acceptStorage.swap(accepting);
+  compiled.transitions = compiled.storage.data();
+  compiled.eofTransitions =
+      compiled.storage.data() + nofNewStates * nofClasses;
+  compiled.accepting = compiled.acceptStorage.data();
+  compiled.nofStates = nofNewStates;
+  _mergeClasses(compiled);
+  _compileLoops(compiled);
+  return MinimizationReport{nofStates, nofNewStates};
+}
+
+bool MealyMachine::isCompiled() const {
+  return _definition->compiled.transitions != nullptr;
+}
+
+size_t MealyMachine::getNofSymbolClasses() const {
+  return _definition->compiled.nofClasses;
 }
 
+Cursor MealyMachine::createCursor() const { return Cursor(*this); }
+
 void MealyMachine::begin() {
+  _tokenBegin        = 0;
+  _acceptKind        = notAccepting;
+  _lookaheadBegin    = 0;
+  _lookahead.clear();
   _currentState      = 0;
   _symbolBufferIndex = 0;
   _readingPosition   = 0;
+  // cursors created before programs were added get their slots here
+  if (_slots.size() < _definition->nofSlots)
+    _slots.resize(_definition->nofSlots, 0);
+}
+
+bool MealyMachine::_parseCompiled(BasicUnit const* data, size_t size) {
+  auto const& compiled   = _definition->compiled;
+  auto const* table      = compiled.transitions;
+  auto const* classes    = compiled.classes;
+  auto const* loops      = compiled.loops;
+  auto const  nofClasses = compiled.nofClasses;
+  auto const  start      = _readingPosition;
+  auto        state      = static_cast<uint32_t>(_currentState);
+  size_t      read       = 0;
+  while (read < size) {
+    auto const& t = table[state * nofClasses + classes[data[read]]];
+    if (t.action == noCompiledAction && t.state != nonexistingCompiledState) {
+      ++read;
+      if (t.state == state && size - read >= minLoopSkip)
+        read = _skipLoop(loops[state], data, read, size);
+      state = t.state;
+      continue;
+    }
+    _currentState      = state;
+    _readingPosition   = start + read;
+    _currentSymbol     = data + read;
+    _currentSymbolSize = 1;
+    if (t.state == nonexistingCompiledState) return _noTransition();
+    _dontMove = false;
+    _call(t.action);
+    state = t.state;
+    if (!_dontMove) ++read;
+  }
+  _currentState    = state;
+  _readingPosition = start + read;
+  return true;
+}
+
+/**
+ * @brief This function parses compiled machine with deferred callbacks.
+ * Callbacks cannot call dontMove, so the scan never leaves the table walk,
+ * transitions with callbacks only append record into action log.
+ * Programs are executed immediately, only they can stop the reading.
+ *
+ * @param data input stream
+ * @param size size of input stream
+ *
+ * @return false if there is no suitable transition
+ */
+bool MealyMachine::_parseCompiledDeferred(BasicUnit const* data, size_t size) {
+  auto const& compiled   = _definition->compiled;
+  auto const* table      = compiled.transitions;
+  auto const* classes    = compiled.classes;
+  auto const* loops      = compiled.loops;
+  auto const  nofClasses = compiled.nofClasses;
+  auto const  start      = _readingPosition;
+  auto        state      = static_cast<uint32_t>(_currentState);
+  size_t      read       = 0;
+  while (read < size) {
+    auto const& t = table[state * nofClasses + classes[data[read]]];
+    if (t.state == nonexistingCompiledState) {
+      _currentState      = state;
+      _readingPosition   = start + read;
+      _currentSymbol     = data + read;
+      _currentSymbolSize = 1;
+      return _noTransition();
+    }
+    bool noMove = false;
+    if (t.action != noCompiledAction) {
+      auto const& a = _definition->actions[t.action];
+      if (a.tokenMarks)
+        _emitTokens(a.tokenMarks, a.tokenKind, a.tokenAfterKind, start + read,
+                    1);
+      if (a.codeSize) {
+        // programs are executed immediately, so they can use noMove
+        _dontMove = false;
+        _execute(_definition->code.data() + a.codeBegin, a.codeSize,
+                 start + read);
+        noMove = _dontMove;
+      }
+      if (a.callback) _actionLog.push_back({t.action, state, start + read});
+    }
+    if (!noMove) ++read;
+    if (t.state == state && t.action == noCompiledAction &&
+        size - read >= minLoopSkip)
+      read = _skipLoop(loops[state], data, read, size);
+    state = t.state;
+  }
+  _currentState    = state;
+  _readingPosition = start + read;
+  return true;
 }
 
 bool MealyMachine::parse(BasicUnit const* data, size_t size) {
-  assert(_currentState < _states.size());
+  if (isCompiled())
+    return _deferred ? _parseCompiledDeferred(data, size)
+                     : _parseCompiled(data, size);
+  assert(_currentState < _definition->states.size());
   size_t      read       = 0;
-  auto const& state      = _states[_currentState];
+  auto const& state      = _definition->states[_currentState];
   auto const& chooser    = std::get<CHOOSER>(state);
   auto        symbolSize = chooser->getSize();
   while (_symbolBufferIndex > 0) {
@@ -235,7 +1350,7 @@ bool MealyMachine::parse(BasicUnit const* data, size_t size) {
   }
 
   do {
-    auto const& state   = _states.at(_currentState);
+    auto const& state   = _definition->states.at(_currentState);
     auto const& chooser = std::get<CHOOSER>(state);
     symbolSize          = chooser->getSize();
 
@@ -257,6 +1372,279 @@ bool MealyMachine::parse(BasicUnit const* data, size_t size) {
   } while (true);
 }
 
+/**
+ * @brief This function runs compiled callback-free machine over one chunk
+ * from several start states at once.
+ * Every distinct state is run only once, start states whose runs meet
+ * share one run from that point. When only one run remains, self-loops
+ * are skipped the same way as in sequential parsing.
+ *
+ * @param compiled compiled table
+ * @param data chunk of input stream
+ * @param size size of chunk
+ * @param starts start states
+ * @param ends end state for every start state, nonexistingCompiledState if
+ * the run fails
+ */
+void MealyMachine::_enumerateChunk(CompiledTable const&         compiled,
+                                   BasicUnit const*             data,
+                                   size_t                       size,
+                                   std::vector<uint32_t> const& starts,
+                                   std::vector<uint32_t>&       ends) {
+  auto const*           table      = compiled.transitions;
+  auto const*           classes    = compiled.classes;
+  auto const            nofClasses = compiled.nofClasses;
+  auto const            none       = nonexistingCompiledState;
+  std::vector<uint32_t> runs;
+  std::vector<uint32_t> nextRuns;
+  std::vector<uint32_t> runOf(starts.size());
+  std::vector<uint32_t> merged;
+  std::vector<uint32_t> runIn(compiled.nofStates, none);
+  for (size_t i = 0; i < starts.size(); ++i) {
+    auto const s = starts[i];
+    if (runIn[s] == none) {
+      runIn[s] = static_cast<uint32_t>(runs.size());
+      runs.push_back(s);
+    }
+    runOf[i] = runIn[s];
+  }
+  for (auto const& s : runs) runIn[s] = none;
+
+  size_t read = 0;
+  while (read < size && runs.size() > 1) {
+    auto const c = classes[data[read++]];
+    nextRuns.clear();
+    merged.resize(runs.size());
+    for (size_t r = 0; r < runs.size(); ++r) {
+      auto const t = table[runs[r] * nofClasses + c].state;
+      if (t == none) {
+        merged[r] = none;
+        continue;
+      }
+      if (runIn[t] == none) {
+        runIn[t] = static_cast<uint32_t>(nextRuns.size());
+        nextRuns.push_back(t);
+      }
+      merged[r] = runIn[t];
+    }
+    for (auto const& s : nextRuns) runIn[s] = none;
+    if (nextRuns.size() != runs.size())
+      for (auto& r : runOf)
+        if (r != none) r = merged[r];
+    runs.swap(nextRuns);
+  }
+
+  if (runs.size() == 1) {
+    auto state = runs[0];
+    while (read < size) {
+      auto const t = table[state * nofClasses + classes[data[read]]].state;
+      if (t == none) {
+        runs.clear();
+        break;
+      }
+      ++read;
+      if (t == state && size - read >= minLoopSkip)
+        read = _skipLoop(compiled.loops[state], data, read, size);
+      state = t;
+    }
+    if (!runs.empty()) runs[0] = state;
+  }
+
+  ends.resize(starts.size());
+  for (size_t i = 0; i < starts.size(); ++i)
+    ends[i] = runOf[i] == none || runs.empty() ? none : runs[runOf[i]];
+}
+
+bool MealyMachine::parseParallel(BasicUnit const* data,
+                                 size_t           size,
+                                 size_t           threads) {
+  _throwIfNotCompiled("parseParallel()");
+  auto const& compiled = _definition->compiled;
+  auto const  nofCells = compiled.nofStates * compiled.nofClasses;
+  for (size_t i = 0; i < nofCells; ++i) {
+    if (compiled.transitions[i].action == noCompiledAction) continue;
+    std::stringstream ss;
+    ss << "MealyMachine::parseParallel - ";
+    ss << "Mealy machine with callbacks cannot be parsed in parallel";
+    throw ex::Exception(ss.str());
+  }
+  if (threads == 0)
+    threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  threads = std::min(threads, size / minParallelChunk);
+  if (threads <= 1) return _parseCompiled(data, size);
+
+  // the first chunk starts in known state, others start in all states
+  std::vector<uint32_t> allStates(compiled.nofStates);
+  for (size_t s = 0; s < allStates.size(); ++s)
+    allStates[s] = static_cast<uint32_t>(s);
+  std::vector<uint32_t> firstState = {static_cast<uint32_t>(_currentState)};
+
+  auto const                         chunkSize = size / threads;
+  std::vector<std::vector<uint32_t>> ends(threads);
+  auto const chunkBegin = [&](size_t c) { return c * chunkSize; };
+  auto const chunkEnd   = [&](size_t c) {
+    return c + 1 == threads ? size : (c + 1) * chunkSize;
+  };
+  std::vector<std::thread> workers;
+  for (size_t c = 1; c < threads; ++c)
+    workers.emplace_back([&, c] {
+      _enumerateChunk(compiled, data + chunkBegin(c),
+                      chunkEnd(c) - chunkBegin(c), allStates, ends[c]);
+    });
+  _enumerateChunk(compiled, data, chunkEnd(0), firstState, ends[0]);
+  for (auto& worker : workers) worker.join();
+
+  auto const start = _readingPosition;
+  for (size_t c = 0; c < threads; ++c) {
+    auto const next = c == 0 ? ends[0][0] : ends[c][_currentState];
+    if (next == nonexistingCompiledState) {
+      // failed chunk is parsed again to report the exact position
+      _readingPosition = start + chunkBegin(c);
+      return _parseCompiled(data + chunkBegin(c), chunkEnd(c) - chunkBegin(c));
+    }
+    _currentState = next;
+  }
+  _readingPosition = start + size;
+  return true;
+}
+
+void MealyMachine::setAccepting(StateIndex const& state, uint32_t kind) {
+  auto& definition = _edit("setAccepting()");
+  _throwIfCompiled("setAccepting()");
+  assert(state < definition.states.size());
+  auto& accepting = definition.accepting;
+  if (accepting.size() < definition.states.size())
+    accepting.resize(definition.states.size(), notAccepting);
+  accepting[state] = kind;
+}
+
+void MealyMachine::setMaxLookahead(size_t bytes) { _maxLookahead = bytes; }
+
+void MealyMachine::reserveLookahead(size_t bytes) {
+  _lookahead.reserve(bytes);
+  _relex.reserve(bytes);
+}
+
+/**
+ * @brief This function lexes one segment of input stream.
+ * If the last accepting position lies in previous segments, the bytes
+ * after it are taken from lookahead buffer and lexed as a separate
+ * segment before this segment is lexed again from its beginning.
+ *
+ * @param data segment of input stream
+ * @param size size of segment
+ *
+ * @return false if no token can be matched
+ */
+bool MealyMachine::_lexSegment(BasicUnit const* data, size_t size) {
+  auto const& compiled   = _definition->compiled;
+  auto const* table      = compiled.transitions;
+  auto const* classes    = compiled.classes;
+  auto const* accepting  = compiled.accepting;
+  auto const  nofClasses = compiled.nofClasses;
+  auto const  base       = _readingPosition;
+  auto        state      = static_cast<uint32_t>(_currentState);
+  size_t      read       = 0;
+  while (read < size) {
+    auto const next = table[state * nofClasses + classes[data[read]]].state;
+    if (next != nonexistingCompiledState) {
+      state = next;
+      ++read;
+      if (accepting[state] == notAccepting) continue;
+      _acceptEnd  = base + read;
+      _acceptKind = accepting[state];
+      continue;
+    }
+    if (_acceptKind == notAccepting) {
+      _currentState      = state;
+      _readingPosition   = base + read;
+      _currentSymbol     = data + read;
+      _currentSymbolSize = 1;
+      return _noTransition();
+    }
+    _emitToken({_tokenBegin, _acceptEnd, _acceptKind});
+    _tokenBegin = _acceptEnd;
+    _acceptKind = notAccepting;
+    state       = 0;
+    if (_tokenBegin >= base) {
+      read = _tokenBegin - base;
+      continue;
+    }
+    // lexing of _relex does not backtrack before its beginning, so it
+    // does not overwrite _relex
+    _relex.assign(_lookahead.begin() + (_tokenBegin - _lookaheadBegin),
+                  _lookahead.end());
+    _lookahead.clear();
+    _lookaheadBegin  = _tokenBegin;
+    _currentState    = 0;
+    _readingPosition = _tokenBegin;
+    if (!_lexSegment(_relex.data(), _relex.size())) return false;
+    state = static_cast<uint32_t>(_currentState);
+    read  = 0;
+  }
+  _currentState    = state;
+  _readingPosition = base + size;
+
+  // only bytes after the last accepting position can be lexed again
+  if (_acceptKind == notAccepting) {
+    _lookahead.clear();
+    _lookaheadBegin = _readingPosition;
+  } else if (_acceptEnd >= base) {
+    _lookahead.assign(data + (_acceptEnd - base), data + size);
+    _lookaheadBegin = _acceptEnd;
+  } else {
+    _lookahead.erase(_lookahead.begin(),
+                     _lookahead.begin() + (_acceptEnd - _lookaheadBegin));
+    _lookahead.insert(_lookahead.end(), data, data + size);
+    _lookaheadBegin = _acceptEnd;
+  }
+  if (_lookahead.size() <= _maxLookahead) return true;
+  if (_quiet) return false;
+  std::stringstream ss;
+  ss << "MealyMachine::lex - ";
+  ss << "lookahead after position " << _acceptEnd << " is longer than "
+     << _maxLookahead << " bytes";
+  throw ex::ParsingError(ss.str());
+  return false;
+}
+
+bool MealyMachine::lex(BasicUnit const* data, size_t size) {
+  _throwIfNotCompiled("lex()");
+  return _lexSegment(data, size);
+}
+
+bool MealyMachine::lex(char const* data) {
+  return lex((BasicUnit const*)data, std::strlen(data));
+}
+
+bool MealyMachine::endLex() {
+  _throwIfNotCompiled("endLex()");
+  while (_readingPosition > _tokenBegin) {
+    if (_acceptKind == notAccepting) {
+      if (_quiet) return false;
+      std::stringstream ss;
+      ss << "MealyMachine::endLex() - ";
+      ss << "input ends inside token that begins at position "
+         << _tokenBegin;
+      throw ex::ParsingError(ss.str());
+    }
+    _emitToken({_tokenBegin, _acceptEnd, _acceptKind});
+    _tokenBegin = _acceptEnd;
+    _acceptKind = notAccepting;
+    // lexing of _relex does not backtrack before its beginning, so it
+    // does not overwrite _relex
+    _relex.assign(_lookahead.begin() + (_tokenBegin - _lookaheadBegin),
+                  _lookahead.end());
+    _lookahead.clear();
+    _lookaheadBegin  = _tokenBegin;
+    _currentState    = 0;
+    _readingPosition = _tokenBegin;
+    if (!_lexSegment(_relex.data(), _relex.size())) return false;
+  }
+  _currentState = 0;
+  return true;
+}
+
 bool MealyMachine::parse(char const* data) {
   return parse((MealyMachine::BasicUnit const*)data, std::strlen(data));
 }
@@ -270,14 +1658,68 @@ bool MealyMachine::end() {
     throw ex::ParsingError(ss.str());
     return false;
   }
-  assert(_currentState < _states.size());
-  auto const& state      = _states[_currentState];
+  if (isCompiled()) {
+    auto const& compiled = _definition->compiled;
+    assert(_currentState < compiled.nofStates);
+    auto const& transition = compiled.eofTransitions[_currentState];
+    if (transition.state == nonexistingCompiledState) return false;
+    _call(transition.action);
+    return true;
+  }
+  assert(_currentState < _definition->states.size());
+  auto const& state      = _definition->states[_currentState];
   auto const& transition = std::get<EOF_TRANSITION>(state);
   if (!transition) return false;
-  _call(*transition);
+  _call(std::get<ACTION>(*transition));
   return true;
 }
 
+void MealyMachine::setDeferred(bool deferred) { _deferred = deferred; }
+
+bool MealyMachine::isDeferred() const { return _deferred; }
+
+void MealyMachine::reserveActionLog(size_t records) {
+  _actionLog.reserve(records);
+}
+
+std::vector<MealyMachine::ActionRecord> const& MealyMachine::getActionLog()
+    const {
+  return _actionLog;
+}
+
+void MealyMachine::replay() {
+  auto const state    = _currentState;
+  auto const position = _readingPosition;
+  auto const symbol   = _currentSymbol;
+  size_t     replayed = 0;
+  try {
+    for (auto const& record : _actionLog) {
+      _currentState    = record.state;
+      _readingPosition = record.position;
+      _currentSymbol   = nullptr;
+      _dontMove        = false;
+      ++replayed;
+      _definition->actions[record.action].callback(this);
+      if (!_dontMove) continue;
+      std::stringstream ss;
+      ss << "MealyMachine::replay - ";
+      ss << "deferred callback cannot call dontMove, position: "
+         << record.position;
+      throw ex::Exception(ss.str());
+    }
+  } catch (...) {
+    _actionLog.erase(_actionLog.begin(), _actionLog.begin() + replayed);
+    _currentState    = state;
+    _readingPosition = position;
+    _currentSymbol   = symbol;
+    throw;
+  }
+  _actionLog.clear();
+  _currentState    = state;
+  _readingPosition = position;
+  _currentSymbol   = symbol;
+}
+
 bool MealyMachine::match(BasicUnit const* data, size_t size) {
   begin();
   return parse(data, size) && end();
@@ -287,15 +1729,159 @@ bool MealyMachine::match(char const* data) {
   return match((BasicUnit const*)data, std::strlen(data));
 }
 
+void MealyMachine::matchMany(Buffer const* inputs,
+                             size_t        count,
+                             uint8_t*      results,
+                             ThreadPool&   pool) const {
+  std::vector<Cursor> cursors;
+  matchMany(inputs, count, results, pool, cursors);
+}
+
+void MealyMachine::matchMany(Buffer const*        inputs,
+                             size_t               count,
+                             uint8_t*             results,
+                             ThreadPool&          pool,
+                             std::vector<Cursor>& cursors) const {
+  // cursors of other machine or of older definition are replaced
+  if (cursors.size() > pool.getNofWorkers())
+    cursors.erase(cursors.begin() + pool.getNofWorkers(), cursors.end());
+  for (auto& cursor : cursors)
+    if (cursor._definition != _definition || cursor._quiet != _quiet)
+      cursor = createCursor();
+  while (cursors.size() < pool.getNofWorkers())
+    cursors.push_back(createCursor());
+  // one pointer fits into small buffer of std::function
+  struct Batch {
+    Buffer const* inputs;
+    uint8_t*      results;
+    Cursor*       cursors;
+  } const batch{inputs, results, cursors.data()};
+  auto const* b = &batch;
+  pool.parallelFor(count, matchManyGrain,
+                   [b](size_t worker, size_t begin, size_t end) {
+                     b->cursors[worker].matchInterleaved(
+                         b->inputs + begin, end - begin, b->results + begin);
+                   });
+}
+
+void MealyMachine::matchMany(std::vector<std::string> const& inputs,
+                             std::vector<uint8_t>&           results,
+                             ThreadPool&                     pool) const {
+  std::vector<Buffer> buffers;
+  buffers.reserve(inputs.size());
+  for (auto const& input : inputs)
+    buffers.push_back({(BasicUnit const*)input.data(), input.size()});
+  results.resize(inputs.size());
+  matchMany(buffers.data(), buffers.size(), results.data(), pool);
+}
+
+void MealyMachine::matchInterleaved(Buffer const* inputs,
+                                    size_t        count,
+                                    uint8_t*      results) {
+  if (!isCompiled()) {
+    for (size_t i = 0; i < count; ++i)
+      results[i] = match(inputs[i].data, inputs[i].size);
+    return;
+  }
+  auto const& compiled   = _definition->compiled;
+  auto const* table      = compiled.transitions;
+  auto const* eof        = compiled.eofTransitions;
+  auto const* classes    = compiled.classes;
+  auto const  nofClasses = compiled.nofClasses;
+  // inputs that have to be matched sequentially
+  uint8_t const pending = 0xff;
+
+  struct Lane {
+    BasicUnit const* data;
+    BasicUnit const* end;
+    uint32_t         state;
+    size_t           input;
+  };
+  Lane   lanes[interleavedLanes];
+  size_t next   = 0;
+  size_t active = 0;
+  auto   refill = [&](Lane& lane) {
+    if (next == count) return false;
+    lane = {inputs[next].data, inputs[next].data + inputs[next].size, 0, next};
+    ++next;
+    return true;
+  };
+  // finished lane leaves the cursor as match() of its input would,
+  // the last input is left again after inputs are matched by match()
+  Lane last  = {};
+  auto leave = [&](Lane const& lane) {
+    _currentState    = lane.state;
+    _readingPosition = lane.data - inputs[lane.input].data;
+    if (lane.data == lane.end) return;
+    _currentSymbol     = lane.data;
+    _currentSymbolSize = 1;
+  };
+  begin();
+  while (active < interleavedLanes && refill(lanes[active])) ++active;
+
+  while (active > 0) {
+    for (size_t k = 0; k < active;) {
+      auto& lane = lanes[k];
+      if (lane.data != lane.end) {
+        auto const& t = table[lane.state * nofClasses + classes[*lane.data]];
+        if (t.action == noCompiledAction &&
+            t.state != nonexistingCompiledState) {
+          lane.state = t.state;
+          ++lane.data;
+          ++k;
+          continue;
+        }
+        if (t.state == nonexistingCompiledState && _quiet)
+          results[lane.input] = false;
+        else
+          results[lane.input] = pending;
+      } else {
+        auto const& t = eof[lane.state];
+        if (t.action == noCompiledAction)
+          results[lane.input] = t.state != nonexistingCompiledState;
+        else
+          results[lane.input] = pending;
+      }
+      if (results[lane.input] != pending) {
+        leave(lane);
+        if (lane.input + 1 == count) last = lane;
+      }
+      // finished lane takes next input or it is replaced by the last lane
+      if (!refill(lane)) lane = lanes[--active];
+    }
+  }
+
+  if (count == 0) return;
+  bool const lastPending = results[count - 1] == pending;
+  for (size_t i = 0; i < count; ++i)
+    if (results[i] == pending)
+      results[i] = match(inputs[i].data, inputs[i].size);
+  if (lastPending) return;
+  begin();
+  leave(last);
+}
+
 const MealyMachine::TransitionIndex MealyMachine::nonexistingTransition =
     std::numeric_limits<MealyMachine::TransitionIndex>::max();
+const uint32_t MealyMachine::nonexistingCompiledState;
+const uint32_t MealyMachine::noCompiledAction;
+const size_t   MealyMachine::compiledSymbols;
+const size_t   MealyMachine::maxLoopRanges;
+const uint8_t  MealyMachine::bitmapLoop;
+const size_t   MealyMachine::minLoopSkip;
+const size_t   MealyMachine::minParallelChunk;
+const size_t   MealyMachine::matchManyGrain;
+const size_t   MealyMachine::interleavedLanes;
+const uint32_t MealyMachine::notAccepting;
+const size_t   MealyMachine::defaultMaxLookahead;
+const uint32_t MealyMachine::maxSlots;
 
 std::string MealyMachine::str() const {
   auto printTransition = [&](Transition const& t) {
     std::stringstream ss;
     auto              endStateIndex = std::get<STATE_INDEX>(t);
-    assert(endStateIndex < _states.size());
-    auto endState = _states.at(endStateIndex);
+    assert(endStateIndex < _definition->states.size());
+    auto endState = _definition->states.at(endStateIndex);
     if (std::get<NAME>(endState) != "")
       ss << std::get<NAME>(endState);
     else
@@ -317,7 +1903,7 @@ std::string MealyMachine::str() const {
 
   std::stringstream ss;
   size_t            stateCounter = 0;
-  for (auto const& s : _states) {
+  for (auto const& s : _definition->states) {
     ss << "state ";
     if (std::get<NAME>(s) != "")
       ss << std::get<NAME>(s);
@@ -330,8 +1916,14 @@ std::string MealyMachine::str() const {
       auto const& chooser = std::get<CHOOSER>(s);
       ss << "  ";
 
-      ss << printSymbol(chooser->getSymbol(transitionCounter),
-                        chooser->getSize());
+      auto const& first = chooser->getSymbol(transitionCounter);
+      auto const& last  = chooser->getLastSymbol(transitionCounter);
+      auto        symbol = printSymbol(first, chooser->getSize());
+      if (std::memcmp(first, last, chooser->getSize()) != 0) {
+        if (symbol.back() == ' ') symbol.pop_back();
+        symbol += " - " + printSymbol(last, chooser->getSize());
+      }
+      ss << symbol;
       if (chooser->getSize() < 2) ss << "  ";
 
       ss << " -> " << printTransition(t);
@@ -9,9 +9,12 @@
 
 #include <MealyMachine/Fwd.h>
 #include <MealyMachine/mealymachine_export.h>
+#include <cstdint>
 #include <functional>
+#include <iosfwd>
 #include <limits>
 #include <memory>
+#include <string>
 #include <tuple>
 #include <vector>
 
@@ -30,13 +33,22 @@ class mealyMachine::MealyMachine {
   using SimpleCallback   = std::function<void()>;
   MEALYMACHINE_EXPORT MealyMachine(size_t largestState = 1);
   MEALYMACHINE_EXPORT virtual ~MealyMachine();
+  /**
+   * @brief Mealy machine cannot be copied, copy would share states and
+   * transitions with the original. Use createCursor() to parse the same
+   * machine several times at once.
+   */
+  MealyMachine(MealyMachine const&) = delete;
+  MealyMachine& operator=(MealyMachine const&) = delete;
+  MEALYMACHINE_EXPORT MealyMachine(MealyMachine&&) noexcept;
+  MEALYMACHINE_EXPORT MealyMachine& operator=(MealyMachine&&) noexcept;
 
   MEALYMACHINE_EXPORT StateIndex addState(std::shared_ptr<TransitionChooser> const& chooser,
                                           std::string const&                        name = "");
 
   /**
    * @brief This function adds new state to Mealy machine.
-   * This function selects MapTransitionChooser as TransitionChooser.
+   * This function selects ArrayTransitionChooser as TransitionChooser.
    *
    * @param name name of the added state
    *
@@ -73,6 +85,9 @@ class mealyMachine::MealyMachine {
 
   /**
    * @brief This function adds/creates transition between two states.
+   * Symbols of the range are compared as unsigned integers with the first
+   * byte being the least significant one, the range contains every symbol
+   * between symbolFrom and symbolTo including both. Empty range is ignored.
    *
    * @param from id of start state
    * @param symbolFrom start of range of accepted transition symbols
@@ -161,6 +176,535 @@ class mealyMachine::MealyMachine {
   MEALYMACHINE_EXPORT void addEOFTransition(StateIndex const& from,
                                             Callback const&   callback = nullptr);
 
+  /**
+   * @brief This structure represents inclusive range of Unicode code points.
+   */
+  struct CodepointRange {
+    uint32_t lo;
+    uint32_t hi;
+  };
+
+  /**
+   * @brief This function adds transitions that read one UTF-8 encoded code
+   * point from range [lo, hi].
+   * The range is compiled into byte level sub-automaton, so the machine
+   * keeps running on 1 byte symbols without decoding.
+   *
+   * @param from id of start state
+   * @param lo first code point of range
+   * @param hi last code point of range
+   * @param to id of end state
+   * @param callback this callback is executed after the last byte of code
+   * point.
+   */
+  MEALYMACHINE_EXPORT void addCodepointRange(StateIndex const& from,
+                                             uint32_t          lo,
+                                             uint32_t          hi,
+                                             StateIndex const& to,
+                                             Callback const&   callback = nullptr);
+
+  /**
+   * @brief This function adds transitions that read one UTF-8 encoded code
+   * point from union of ranges.
+   * Intermediate states are shared by all byte sequences with the same
+   * remaining suffix, so the sub-automaton is minimal. Surrogates and
+   * overlong encodings are not accepted. State "from" has to use 1 byte
+   * transition chooser and it must not have other transitions on lead
+   * bytes of the ranges.
+   *
+   * @param from id of start state
+   * @param ranges code point ranges, they can overlap
+   * @param to id of end state
+   * @param callback this callback is executed after the last byte of code
+   * point.
+   */
+  MEALYMACHINE_EXPORT void addCodepointRanges(StateIndex const&                  from,
+                                              std::vector<CodepointRange> const& ranges,
+                                              StateIndex const&                  to,
+                                              Callback const&                    callback = nullptr);
+
+  /**
+   * @brief This function freezes the Mealy machine.
+   * All states, transition choosers, else and EOF transitions are lowered
+   * into one contiguous state x symbol class table and parse/end use only
+   * this table. Symbols that lead to the same transition in every state
+   * form one symbol class, so the table has one column per class.
+   * All states have to use transition choosers with 1 byte symbols.
+   * Chains of non-consuming transitions are collapsed (see nonConsuming).
+   * Transitions cannot be added to compiled Mealy machine.
+   */
+  MEALYMACHINE_EXPORT void compile();
+
+  /**
+   * @brief This function returns true if the Mealy machine was compiled.
+   *
+   * @return true if compile() was called
+   */
+  MEALYMACHINE_EXPORT bool isCompiled() const;
+
+  /**
+   * @brief This function returns number of symbol classes of compiled
+   * machine.
+   *
+   * @return number of columns of compiled table, 0 if it is not compiled
+   */
+  MEALYMACHINE_EXPORT size_t getNofSymbolClasses() const;
+
+  /**
+   * @brief This structure contains number of states before and after
+   * minimization.
+   */
+  struct MinimizationReport {
+    size_t statesBefore;
+    size_t statesAfter;
+  };
+
+  /**
+   * @brief This function minimizes compiled Mealy machine.
+   * The machine is compiled first if it is not compiled yet.
+   * States that cannot be distinguished are merged using Hopcroft's
+   * algorithm and unreachable states are removed. Transitions are
+   * distinguished by their callbacks; callbacks are the same only if they
+   * were added by the same call of addTransition.
+   * States are renumbered, start state stays 0.
+   *
+   * @return number of states before and after minimization
+   */
+  MEALYMACHINE_EXPORT MinimizationReport minimize();
+
+  /**
+   * @brief This function saves compiled Mealy machine into binary file.
+   * The file contains versioned header and tables of the compiled machine
+   * at aligned offsets, so it does not depend on address where it is
+   * loaded. Callbacks are not saved, token marks, kinds and programs are.
+   *
+   * @param path path of the file
+   */
+  MEALYMACHINE_EXPORT void save(std::string const& path) const;
+
+  /**
+   * @brief This function loads Mealy machine saved by save().
+   * The file is memory mapped read-only where it is possible and the
+   * tables are used in place, so loading does not depend on size of the
+   * machine and processes share the pages. Callbacks have to be bound
+   * again using bindAction. Header, section offsets and action programs are
+   * validated, table contents are not, call verify() for files that are
+   * not trusted.
+   *
+   * @param path path of the file
+   *
+   * @return compiled Mealy machine
+   */
+  MEALYMACHINE_EXPORT static MealyMachine load(std::string const& path);
+
+  /**
+   * @brief This function checks tables of compiled Mealy machine.
+   * Every cell, symbol class and self-loop is checked, so it takes time
+   * proportional to size of the table and touches all its pages.
+   * Parse of corrupted table can crash, verify throws instead.
+   */
+  MEALYMACHINE_EXPORT void verify() const;
+
+  /**
+   * @brief This function returns number of actions.
+   * Every call of addTransition, addElseTransition or addEOFTransition
+   * with non-empty callback adds one action, actions are numbered in order
+   * of these calls.
+   *
+   * @return number of actions
+   */
+  MEALYMACHINE_EXPORT size_t getNofActions() const;
+
+  /**
+   * @brief This function replaces callback of action.
+   * It is used to bind callbacks of loaded Mealy machine. The action is
+   * shared by all cursors.
+   *
+   * @param action id of action
+   * @param callback new callback
+   */
+  MEALYMACHINE_EXPORT void bindAction(size_t action, Callback const& callback);
+
+  /**
+   * @brief This function writes compiled Mealy machine as self-contained
+   * C++ header with direct coded scanner.
+   * Every state is a label, symbols are tested by comparisons of ranges
+   * and transitions are gotos (computed goto on GCC and Clang, switch
+   * otherwise). The scanner calls functor with action id like
+   * BasicMealyMachine does, callbacks, token marks and programs are not
+   * emitted. It throws if a program that was not collapsed by compile()
+   * uses noMove, the scanner would read the symbol.
+   *
+   * @param out output stream
+   * @param name name of generated scanner class
+   */
+  MEALYMACHINE_EXPORT void emitCpp(std::ostream&      out,
+                                   std::string const& name = "Scanner") const;
+
+  /**
+   * @brief This function creates new cursor to this Mealy machine.
+   * Cursor shares states, transitions and callbacks with this Mealy machine
+   * read-only, it has its own position, state, symbol buffer, slots and
+   * tokens. Cursors of one Mealy machine can parse concurrently from
+   * different threads if the machine is not modified at the same time.
+   * Callbacks are shared too, they receive the cursor as their parameter,
+   * functions that modify the machine throw if they are called on it.
+   *
+   * @return new cursor that is ready to parse
+   */
+  MEALYMACHINE_EXPORT Cursor createCursor() const;
+
+  /**
+   * @brief This function parses one large buffer using several threads.
+   * The buffer is split into chunks and every chunk is run from all states
+   * at once; runs that reach the same state are merged, so most chunks are
+   * soon run from one state only. Results of chunks are stitched together
+   * so the state, reading position and errors are the same as if
+   * parse(data, size) was called.
+   * The Mealy machine has to be compiled and it cannot have callbacks
+   * on symbol transitions, EOF callbacks are allowed.
+   *
+   * @param data input stream
+   * @param size size of input stream
+   * @param threads number of threads, 0 means number of hardware threads
+   *
+   * @return false if there is no suitable transition and machine is quiet
+   */
+  MEALYMACHINE_EXPORT bool parseParallel(BasicUnit const* data,
+                                         size_t           size,
+                                         size_t           threads = 0);
+
+  /**
+   * @brief This structure represents one input of batch matching.
+   */
+  struct Buffer {
+    BasicUnit const* data;
+    size_t           size;
+  };
+
+  /**
+   * @brief This function matches many inputs using thread pool.
+   * Every worker of the pool matches chunks of inputs using
+   * matchInterleaved of its own cursor, so callbacks can be called
+   * concurrently from different threads.
+   * If the machine is not quiet, the first exception is rethrown.
+   *
+   * @param inputs inputs
+   * @param count number of inputs
+   * @param results results of match, one per input
+   * @param pool thread pool
+   */
+  MEALYMACHINE_EXPORT void matchMany(Buffer const* inputs,
+                                     size_t        count,
+                                     uint8_t*      results,
+                                     ThreadPool&   pool) const;
+
+  /**
+   * @brief This function matches many inputs using thread pool and cursors
+   * kept by the caller between calls.
+   * Missing cursors and cursors of other machine are created, so repeated
+   * calls with the same pool and cursors do not allocate.
+   *
+   * @param inputs inputs
+   * @param count number of inputs
+   * @param results results of match, one per input
+   * @param pool thread pool
+   * @param cursors cursors, one per worker of the pool
+   */
+  MEALYMACHINE_EXPORT void matchMany(Buffer const*        inputs,
+                                     size_t               count,
+                                     uint8_t*             results,
+                                     ThreadPool&          pool,
+                                     std::vector<Cursor>& cursors) const;
+
+  /**
+   * @brief This function matches many strings using thread pool.
+   *
+   * @param inputs inputs
+   * @param results results of match, it is resized to the number of inputs
+   * @param pool thread pool
+   */
+  MEALYMACHINE_EXPORT void matchMany(std::vector<std::string> const& inputs,
+                                     std::vector<uint8_t>&           results,
+                                     ThreadPool&                     pool) const;
+
+  /**
+   * @brief This function matches several inputs on one thread.
+   * Compiled machine advances interleavedLanes inputs in lockstep, so table
+   * lookups of different inputs overlap. Inputs that reach a callback or
+   * an error (if the machine is not quiet) are matched again by match()
+   * in input order after that, so the results, callbacks and exceptions
+   * are the same as if match() was called for every input.
+   * The machine is left in the state and reading position of match() of
+   * the last input.
+   * Machine that is not compiled calls match() for every input.
+   *
+   * @param inputs inputs
+   * @param count number of inputs
+   * @param results results of match, one per input
+   */
+  MEALYMACHINE_EXPORT void matchInterleaved(Buffer const* inputs,
+                                            size_t        count,
+                                            uint8_t*      results);
+
+  /**
+   * @brief This enum contains token boundary marks of a transition.
+   * Marks of one transition are applied in order TOKEN_END, TOKEN_BEGIN,
+   * TOKEN_END_AFTER, so one transition can end previous token and begin
+   * new one.
+   */
+  enum TokenMarks : uint8_t {
+    TOKEN_END       = 1,  ///< token ends before current symbol
+    TOKEN_BEGIN     = 2,  ///< token begins at current symbol
+    TOKEN_END_AFTER = 4,  ///< token ends after current symbol
+  };
+
+  /**
+   * @brief This structure represents one emitted token.
+   * begin and end are positions in input stream, end is not included.
+   */
+  struct TokenRecord {
+    size_t   begin;
+    size_t   end;
+    uint32_t kind;
+  };
+
+  /**
+   * @brief This function creates token callback.
+   * Token callback can be used as callback of any transition. Its marks
+   * are applied by the machine directly without calling std::function,
+   * ended tokens are written into token buffer.
+   * EOF transitions should use TOKEN_END only.
+   *
+   * @param marks combination of TokenMarks
+   * @param kind kind of tokens that are ended by the transition
+   * @param callback optional user callback that is called after marks
+   *
+   * @return callback that can be passed to addTransition
+   */
+  MEALYMACHINE_EXPORT static Callback token(uint8_t         marks,
+                                            uint32_t        kind     = 0,
+                                            Callback const& callback = nullptr);
+
+  /**
+   * @brief This function creates token callback whose TOKEN_END and
+   * TOKEN_END_AFTER tokens have different kinds.
+   * It is used by transitions that end previous token and emit the token
+   * of current symbol, e.g. operator after a number.
+   *
+   * @param marks combination of TokenMarks
+   * @param endKind kind of token ended by TOKEN_END
+   * @param afterKind kind of token ended by TOKEN_END_AFTER
+   * @param callback optional user callback that is called after marks
+   *
+   * @return callback that can be passed to addTransition
+   */
+  MEALYMACHINE_EXPORT static Callback token(uint8_t         marks,
+                                            uint32_t        endKind,
+                                            uint32_t        afterKind,
+                                            Callback const& callback = nullptr);
+
+  /**
+   * @brief This function sets caller-supplied buffer for emitted tokens.
+   * Tokens are appended after previous tokens until clearTokens() is called,
+   * exception is thrown if the buffer is full.
+   *
+   * @param buffer token buffer
+   * @param capacity number of tokens that fit into buffer
+   */
+  MEALYMACHINE_EXPORT void setTokenBuffer(TokenRecord* buffer, size_t capacity);
+
+  /**
+   * @brief This function returns number of tokens in token buffer.
+   *
+   * @return number of emitted tokens
+   */
+  MEALYMACHINE_EXPORT size_t getNofTokens() const;
+  MEALYMACHINE_EXPORT void   clearTokens();
+
+  /**
+   * @brief This enum contains operations of action instructions.
+   */
+  enum Opcode : uint8_t {
+    OP_INC     = 0,  ///< increments slot
+    OP_MARK    = 1,  ///< stores reading position into slot
+    OP_NO_MOVE = 2,  ///< the same as dontMove()
+    OP_EMIT    = 3,  ///< emits token that ends before current symbol
+  };
+
+  static const uint32_t maxSlots = 1 << 16;
+
+  /**
+   * @brief This structure represents one instruction of action program.
+   * operand is slot of OP_INC and OP_MARK and token kind of OP_EMIT.
+   */
+  struct Instruction {
+    Opcode   opcode;
+    uint32_t operand;
+  };
+
+  MEALYMACHINE_EXPORT static Instruction inc(uint32_t slot);
+  MEALYMACHINE_EXPORT static Instruction mark(uint32_t slot);
+  MEALYMACHINE_EXPORT static Instruction noMove();
+  MEALYMACHINE_EXPORT static Instruction emit(uint32_t kind);
+
+  /**
+   * @brief This function creates program callback.
+   * Program callback can be used as callback of any transition like
+   * token(). Its instructions are executed by the machine in a small
+   * interpreter without calling std::function, they are applied after
+   * token marks and before optional user callback. Programs are saved by
+   * save(), they are executed even if the machine is deferred.
+   * OP_EMIT token begins at the last TOKEN_BEGIN mark.
+   * @code
+   * using M = mealyMachine::MealyMachine;
+   * mm.addElseTransition(P, S, M::program({M::inc(0), M::noMove()}));
+   * @endcode
+   *
+   * @param instructions instructions executed in order
+   * @param callback optional user callback that is called after program
+   *
+   * @return callback that can be passed to addTransition
+   */
+  MEALYMACHINE_EXPORT static Callback program(
+      std::vector<Instruction> const& instructions,
+      Callback const&                 callback = nullptr);
+
+  /**
+   * @brief This function creates callback of non-consuming transition.
+   * Non-consuming transition does not read current symbol, the symbol is
+   * read again in "to" state like after dontMove(), but the machine knows
+   * it before parsing. compile() collapses chains of non-consuming
+   * transitions into direct cells of the table if the transitions have
+   * no user callbacks, so the symbol is dispatched by one table lookup;
+   * programs and token marks of the chain are merged into one action.
+   * Actions and errors of collapsed cells see the first state of the chain
+   * as current state.
+   * @code
+   * using M = mealyMachine::MealyMachine;
+   * mm.addElseTransition(P, S, M::nonConsuming(M::program({M::inc(0)})));
+   * @endcode
+   *
+   * @param callback optional program, token or user callback
+   *
+   * @return callback that can be passed to addTransition
+   */
+  MEALYMACHINE_EXPORT static Callback nonConsuming(
+      Callback const& callback = nullptr);
+
+  /**
+   * @brief This function returns value of slot of action programs.
+   * Slots belong to the cursor, they are 0 at the beginning and they are
+   * kept across match() calls until clearSlots() is called. Slots are
+   * allocated when the program is added and by begin(), so parsing does
+   * not allocate. Slot has to be less than maxSlots.
+   *
+   * @param slot id of slot
+   *
+   * @return value of slot, 0 if the slot was not used yet
+   */
+  MEALYMACHINE_EXPORT size_t getSlot(size_t slot) const;
+  MEALYMACHINE_EXPORT void   clearSlots();
+
+  /**
+   * @brief This function marks state as accepting state of lexer.
+   * The kind is used for tokens that end in this state, see lex().
+   *
+   * @param state id of state
+   * @param kind kind of tokens that end in the state
+   */
+  MEALYMACHINE_EXPORT void setAccepting(StateIndex const& state,
+                                        uint32_t          kind);
+
+  /**
+   * @brief This function sets maximal number of bytes that lexer keeps
+   * for backtracking across parse chunks.
+   *
+   * @param bytes maximal length of lookahead buffer
+   */
+  MEALYMACHINE_EXPORT void setMaxLookahead(size_t bytes);
+
+  /**
+   * @brief This function preallocates lookahead buffers of lexer, so
+   * backtracking across parse chunks does not allocate.
+   *
+   * @param bytes number of bytes that fit into the buffers
+   */
+  MEALYMACHINE_EXPORT void reserveLookahead(size_t bytes);
+
+  /**
+   * @brief This function splits input into tokens using longest match.
+   * Compiled machine is run from state 0 at the beginning of every token.
+   * Last position where the machine was in accepting state is remembered;
+   * when there is no suitable transition, the token ends at that position,
+   * it is written into token buffer and lexing continues from that position.
+   * Bytes after the last accepting position are kept in lookahead buffer,
+   * so tokens can span lex() calls.
+   * Callbacks, token marks and programs of transitions are not used by
+   * lexer.
+   *
+   * @param data input stream
+   * @param size size of input stream
+   *
+   * @return false if no token can be matched and machine is quiet
+   */
+  MEALYMACHINE_EXPORT bool lex(BasicUnit const* data, size_t size);
+  MEALYMACHINE_EXPORT bool lex(char const* data);
+
+  /**
+   * @brief This function ends lexing of input stream.
+   * Unfinished token is written into token buffer.
+   *
+   * @return false if the input ends inside token that cannot be accepted
+   */
+  MEALYMACHINE_EXPORT bool endLex();
+
+  /**
+   * @brief This structure represents one deferred callback.
+   * It contains action id, "from" state and reading position of the
+   * transition.
+   */
+  struct ActionRecord {
+    uint32_t action;
+    uint32_t state;
+    size_t   position;
+  };
+
+  /**
+   * @brief This function enables or disables deferred callbacks.
+   * Deferred Mealy machine does not call callbacks during parsing, it only
+   * appends records into action log. Callbacks are called later by replay().
+   * Callbacks of deferred machine cannot call dontMove(). Token marks and
+   * programs are applied immediately, programs can use noMove().
+   *
+   * @param deferred true if callbacks should be deferred
+   */
+  MEALYMACHINE_EXPORT void setDeferred(bool deferred);
+  MEALYMACHINE_EXPORT bool isDeferred() const;
+
+  /**
+   * @brief This function preallocates action log.
+   *
+   * @param records number of records that fit into the log
+   */
+  MEALYMACHINE_EXPORT void reserveActionLog(size_t records);
+
+  /**
+   * @brief This function returns records of deferred callbacks.
+   *
+   * @return action log
+   */
+  MEALYMACHINE_EXPORT std::vector<ActionRecord> const& getActionLog() const;
+
+  /**
+   * @brief This function calls all deferred callbacks in order and clears
+   * the action log.
+   * Callbacks see reading position and "from" state of their transition,
+   * current symbol is nullptr. State and reading position of the machine
+   * are restored after replay.
+   */
+  MEALYMACHINE_EXPORT void replay();
+
   MEALYMACHINE_EXPORT virtual void begin();
   MEALYMACHINE_EXPORT virtual bool parse(BasicUnit const* data, size_t size);
   MEALYMACHINE_EXPORT bool         parse(char const* data);
@@ -210,7 +754,8 @@ class mealyMachine::MealyMachine {
 
  protected:
   using TransitionSymbolIndex = size_t;
-  using Transition            = std::tuple<StateIndex, Callback>;
+  using ActionIndex           = size_t;
+  using Transition            = std::tuple<StateIndex, ActionIndex>;
   using TransitionVector      = std::vector<Transition>;
 
  public:
@@ -218,6 +763,14 @@ class mealyMachine::MealyMachine {
   static const TransitionIndex nonexistingTransition;
 
  protected:
+  friend class AhoCorasickBuilder;
+  template <size_t>
+  friend class StaticMealyMachineBuilder;
+  template <size_t, size_t>
+  friend class StaticMealyMachine;
+  template <typename>
+  friend class BasicMealyMachine;
+  friend class Cursor;
   using State = std::tuple<TransitionVector,
                            std::shared_ptr<TransitionChooser>,
                            std::shared_ptr<Transition>,
@@ -225,7 +778,7 @@ class mealyMachine::MealyMachine {
                            std::string>;
   enum TransitionParts {
     STATE_INDEX = 0,
-    CALLBACK    = 1,
+    ACTION      = 1,
   };
   enum StateParts {
     TRANSITIONS     = 0,
@@ -234,19 +787,200 @@ class mealyMachine::MealyMachine {
     EOF_TRANSITION  = 3,
     NAME            = 4,
   };
-  inline void            _call(Transition const& transitions);
+  /**
+   * @brief This structure represents one cell of compiled transition table.
+   */
+  struct CompiledTransition {
+    uint32_t state;
+    uint32_t action;
+  };
+  static const uint32_t nonexistingCompiledState = 0xffffffffu;
+  static const uint32_t noCompiledAction         = 0xffffffffu;
+  static const size_t   compiledSymbols          = 256;
+  static const size_t   maxLoopRanges            = 4;
+  static const uint8_t  bitmapLoop               = 0xff;
+  static const size_t   minLoopSkip              = 16;
+  static const size_t   minParallelChunk         = 1 << 16;
+  static const size_t   matchManyGrain           = 256;
+  static const size_t   interleavedLanes         = 8;
+  static const uint32_t notAccepting             = 0xffffffffu;
+  static const size_t   defaultMaxLookahead      = 1 << 16;
+  /**
+   * @brief This structure describes callback-free self-loop of a state.
+   * stay contains bitmap of symbols that keep the state.
+   * If the symbols form at most maxLoopRanges ranges, they are stored
+   * in ranges and they are scanned using SIMD instructions,
+   * nofRanges is bitmapLoop otherwise.
+   * nofRanges is 0 if the state has no such self-loop.
+   * Self-loops are skipped only if at least minLoopSkip symbols remain.
+   */
+  struct CompiledLoop {
+    uint8_t nofRanges;
+    uint8_t ranges[maxLoopRanges][2];
+    uint8_t stay[compiledSymbols / 8];
+  };
+  /**
+   * @brief This structure represents frozen Mealy machine.
+   * Symbols that behave the same way in all states share one symbol class,
+   * classes maps every symbol to its class.
+   * transitions contains nofStates x nofClasses cells,
+   * eofTransitions contains one cell per state, eof cell with
+   * nonexistingCompiledState state means that there is no EOF transition.
+   * loops contains one self-loop description per state.
+   * accepting contains lexer token kind per state, notAccepting if the
+   * state is not accepting.
+   */
+  struct CompiledTable {
+    std::vector<CompiledTransition> storage;
+    std::vector<CompiledLoop>       loopStorage;
+    std::vector<uint8_t>            classStorage;
+    std::vector<uint32_t>           acceptStorage;
+    CompiledTransition const*       transitions    = nullptr;
+    CompiledTransition const*       eofTransitions = nullptr;
+    CompiledLoop const*             loops          = nullptr;
+    uint8_t const*                  classes        = nullptr;
+    uint32_t const*                 accepting      = nullptr;
+    size_t                          nofClasses     = 0;
+    size_t                          nofStates      = 0;
+  };
+  struct TokenCallback;
+  struct ProgramCallback;
+  /**
+   * @brief This structure represents action of transition.
+   * Token marks are applied before program, program is executed before
+   * user callback. Program is stored in Definition::code.
+   */
+  struct Action {
+    Callback callback;
+    uint8_t  tokenMarks     = 0;
+    uint32_t tokenKind      = 0;
+    uint32_t tokenAfterKind = 0;
+    uint32_t codeBegin      = 0;
+    uint32_t codeSize       = 0;
+  };
+  /**
+   * @brief This structure contains definition of Mealy machine.
+   * It is shared by all cursors of the Mealy machine, only the machine
+   * that created it can modify it.
+   * file keeps mapped file alive if the compiled table was loaded.
+   */
+  struct Definition {
+    std::vector<State>          states;
+    std::vector<Action>         actions;
+    std::vector<uint32_t>       accepting;
+    std::vector<Instruction>    code;
+    uint32_t                    nofSlots = 0;
+    CompiledTable               compiled;
+    std::shared_ptr<void const> file;
+  };
+  MealyMachine(std::shared_ptr<Definition const> const& definition,
+               size_t                                   largestState);
+  Definition&            _edit(std::string const& where);
+  ActionIndex            _addAction(Callback const& callback);
+  void                   _addTransition(StateIndex const&       from,
+                                        TransitionSymbol const& symbol,
+                                        StateIndex const&       to,
+                                        ActionIndex const&      action);
+  void                   _throwIfCompiled(std::string const& where) const;
+  void                   _throwIfNotCompiled(std::string const& where) const;
+  bool                   _noTransition();
+  inline void            _call(ActionIndex const& action);
+  uint32_t               _reserveSlots(std::vector<Instruction> const& program);
+  MEALYMACHINE_EXPORT bool _compiledNoMove() const;
+  inline void            _execute(Instruction const* code,
+                                  size_t             size,
+                                  size_t             position);
+  void                   _emitTokens(uint8_t  marks,
+                                     uint32_t kind,
+                                     uint32_t afterKind,
+                                     size_t   position,
+                                     size_t   symbolSize);
   inline bool            _nextState(State const& state);
+  void                   _lowerState(StateIndex const&   s,
+                                     CompiledTransition* row) const;
+  static void            _compileLoops(CompiledTable& compiled);
+  void                   _collapseNonConsuming(CompiledTable& compiled);
+  static constexpr CompiledLoop _computeLoop(CompiledTransition const* row,
+                                             uint8_t const* classes,
+                                             size_t         state);
+  static void            _mergeClasses(CompiledTable& compiled);
+  bool                   _parseCompiled(BasicUnit const* data, size_t size);
+  bool                   _parseCompiledDeferred(BasicUnit const* data,
+                                                size_t           size);
+  static void            _enumerateChunk(CompiledTable const&         compiled,
+                                         BasicUnit const*             data,
+                                         size_t                       size,
+                                         std::vector<uint32_t> const& starts,
+                                         std::vector<uint32_t>&       ends);
+  bool                   _lexSegment(BasicUnit const* data, size_t size);
+  void                   _emitToken(TokenRecord const& token);
+  MEALYMACHINE_EXPORT static size_t _skipLoop(CompiledLoop const& loop,
+                                   BasicUnit const*    data,
+                                   size_t              read,
+                                   size_t              size);
   bool                   _quiet             = false;
   bool                   _dontMove          = false;
+  bool                   _deferred          = false;
   size_t                 _readingPosition   = 0;
   TransitionSymbol       _currentSymbol     = nullptr;
   size_t                 _currentSymbolSize = 0;
-  std::vector<State>     _states;
+  std::shared_ptr<Definition const> _definition;
+  std::shared_ptr<Definition>       _editable;
   StateIndex             _currentState = 0;
   std::vector<BasicUnit> _symbolBuffer;
   TransitionSymbolIndex  _symbolBufferIndex = 0;
+  std::vector<ActionRecord> _actionLog;
+  TokenRecord*           _tokens         = nullptr;
+  size_t                 _tokenCapacity  = 0;
+  size_t                 _nofTokens      = 0;
+  size_t                 _tokenBegin     = 0;
+  size_t                 _acceptEnd      = 0;
+  uint32_t               _acceptKind     = notAccepting;
+  size_t                 _maxLookahead   = defaultMaxLookahead;
+  size_t                 _lookaheadBegin = 0;
+  std::vector<BasicUnit> _lookahead;
+  // bytes after backtracked token that are lexed again
+  std::vector<BasicUnit> _relex;
+  std::vector<size_t>    _slots;
 };
 
+/**
+ * @brief This function computes self-loop description of compiled state.
+ * It is constexpr so that tables of StaticMealyMachine are computed during
+ * compilation.
+ *
+ * @param row transitions of the state
+ * @param classes symbol classes
+ * @param state the state
+ *
+ * @return description of the self-loop
+ */
+constexpr mealyMachine::MealyMachine::CompiledLoop
+mealyMachine::MealyMachine::_computeLoop(CompiledTransition const* row,
+                                         uint8_t const*            classes,
+                                         size_t                    state) {
+  CompiledLoop loop{};
+  for (size_t symbol = 0; symbol < compiledSymbols; ++symbol) {
+    auto const& cell = row[classes[symbol]];
+    if (cell.state != state || cell.action != noCompiledAction) continue;
+    loop.stay[symbol / 8] |= static_cast<uint8_t>(1u << (symbol % 8));
+    bool const continues = symbol > 0 && loop.nofRanges > 0 &&
+                           loop.nofRanges <= maxLoopRanges &&
+                           loop.ranges[loop.nofRanges - 1][1] == symbol - 1;
+    if (continues) {
+      loop.ranges[loop.nofRanges - 1][1] = static_cast<uint8_t>(symbol);
+      continue;
+    }
+    if (loop.nofRanges < maxLoopRanges) {
+      loop.ranges[loop.nofRanges][0] = static_cast<uint8_t>(symbol);
+      loop.ranges[loop.nofRanges][1] = static_cast<uint8_t>(symbol);
+    }
+    if (loop.nofRanges <= maxLoopRanges) loop.nofRanges++;
+  }
+  if (loop.nofRanges > maxLoopRanges) loop.nofRanges = bitmapLoop;
+  return loop;
+}
+
 inline size_t const& mealyMachine::MealyMachine::getReadingPosition() const {
   return _readingPosition;
 }
@@ -262,3 +996,52 @@ mealyMachine::MealyMachine::getCurrentState() const {
 }
 
 inline void mealyMachine::MealyMachine::dontMove() { _dontMove = true; }
+
+/**
+ * @brief This class represents cursor of Mealy machine.
+ * Cursor holds only the state of one parse: position, current state,
+ * symbol buffer, slots, tokens, action log and lookahead of lexer.
+ * Definition of the machine is shared read-only, so the cursor does not
+ * provide functions that build or compile the machine. Callbacks receive
+ * the cursor as MealyMachine, functions that modify the machine throw if
+ * they are called through it.
+ */
+class mealyMachine::Cursor : private mealyMachine::MealyMachine {
+  friend class MealyMachine;
+
+ public:
+  MEALYMACHINE_EXPORT explicit Cursor(MealyMachine const& machine);
+  Cursor(Cursor&&) noexcept = default;
+  Cursor& operator=(Cursor&&) noexcept = default;
+  using MealyMachine::ActionRecord;
+  using MealyMachine::BasicUnit;
+  using MealyMachine::Buffer;
+  using MealyMachine::StateIndex;
+  using MealyMachine::TokenRecord;
+  using MealyMachine::TransitionSymbol;
+  using MealyMachine::begin;
+  using MealyMachine::clearSlots;
+  using MealyMachine::clearTokens;
+  using MealyMachine::dontMove;
+  using MealyMachine::end;
+  using MealyMachine::endLex;
+  using MealyMachine::getActionLog;
+  using MealyMachine::getCurrentState;
+  using MealyMachine::getCurrentSymbol;
+  using MealyMachine::getNofTokens;
+  using MealyMachine::getReadingPosition;
+  using MealyMachine::getSlot;
+  using MealyMachine::isDeferred;
+  using MealyMachine::isQuiet;
+  using MealyMachine::lex;
+  using MealyMachine::match;
+  using MealyMachine::matchInterleaved;
+  using MealyMachine::parse;
+  using MealyMachine::replay;
+  using MealyMachine::reserveActionLog;
+  using MealyMachine::reserveLookahead;
+  using MealyMachine::setDeferred;
+  using MealyMachine::setMaxLookahead;
+  using MealyMachine::setQuiet;
+  using MealyMachine::setTokenBuffer;
+};
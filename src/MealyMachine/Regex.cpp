@@ -0,0 +1,636 @@
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cctype>
+#include <limits>
+#include <map>
+#include <sstream>
+
+#include <MealyMachine/Exception.h>
+#include <MealyMachine/Regex.h>
+
+using namespace mealyMachine;
+
+namespace {
+
+size_t const none          = std::numeric_limits<size_t>::max();
+size_t const maxRepetition = 1000;
+size_t const maxDfaStates  = 1 << 14;
+size_t const maxNfaNodes   = 1 << 18;
+size_t const nofSymbols    = 256;
+
+using Symbols = std::bitset<nofSymbols>;
+
+// sorted pairs of tag and consuming or matching node reached after it
+using TagReach = std::vector<std::pair<size_t, size_t>>;
+
+/**
+ * @brief This structure represents node of abstract syntax tree of regular
+ * expression.
+ */
+struct Ast {
+  enum Kind {
+    SET,
+    CONCATENATION,
+    ALTERNATION,
+    REPETITION,
+    GROUP,
+  };
+  Kind                              kind;
+  Symbols                           symbols;
+  std::vector<std::shared_ptr<Ast>> children;
+  size_t                            min   = 0;
+  size_t                            max   = 0;
+  size_t                            group = 0;
+};
+
+std::shared_ptr<Ast> newAst(Ast::Kind kind) {
+  auto ast  = std::make_shared<Ast>();
+  ast->kind = kind;
+  return ast;
+}
+
+Symbols range(size_t from, size_t to) {
+  Symbols symbols;
+  for (auto s = from; s <= to; ++s) symbols.set(s);
+  return symbols;
+}
+
+/**
+ * @brief This class parses regular expression using recursive descent.
+ */
+class Parser {
+ public:
+  Parser(std::string const& pattern, size_t& nofGroups)
+      : _pattern(pattern), _nofGroups(nofGroups) {}
+  std::shared_ptr<Ast> parse() {
+    auto ast = _alternation();
+    if (_position < _pattern.size()) _error("unexpected )");
+    return ast;
+  }
+
+ protected:
+  bool _end() const { return _position == _pattern.size(); }
+  char _peek() const { return _pattern[_position]; }
+  char _get() {
+    if (_end()) _error("unexpected end of pattern");
+    return _pattern[_position++];
+  }
+  [[noreturn]] void _error(std::string const& message) const {
+    std::stringstream ss;
+    ss << "MealyMachine::compileRegex - ";
+    ss << message << " at position " << _position << " of pattern: ";
+    ss << _pattern;
+    throw ex::Exception(ss.str());
+  }
+  std::shared_ptr<Ast> _alternation() {
+    auto first = _concatenation();
+    if (_end() || _peek() != '|') return first;
+    auto ast = newAst(Ast::ALTERNATION);
+    ast->children.push_back(first);
+    while (!_end() && _peek() == '|') {
+      ++_position;
+      ast->children.push_back(_concatenation());
+    }
+    return ast;
+  }
+  std::shared_ptr<Ast> _concatenation() {
+    auto ast = newAst(Ast::CONCATENATION);
+    while (!_end() && _peek() != '|' && _peek() != ')')
+      ast->children.push_back(_repetition());
+    return ast;
+  }
+  std::shared_ptr<Ast> _repetition() {
+    auto ast = _atom();
+    while (!_end()) {
+      size_t min = 0;
+      size_t max = none;
+      switch (_peek()) {
+        case '*': ++_position; break;
+        case '+':
+          ++_position;
+          min = 1;
+          break;
+        case '?':
+          ++_position;
+          max = 1;
+          break;
+        case '{':
+          ++_position;
+          min = _number();
+          max = min;
+          if (_get() == ',') {
+            max = none;
+            if (_peek() != '}') max = _number();
+            if (_get() != '}') _error("expected }");
+          } else if (_pattern[_position - 1] != '}')
+            _error("expected }");
+          if (max < min) _error("invalid repetition range");
+          break;
+        default: return ast;
+      }
+      auto repetition = newAst(Ast::REPETITION);
+      repetition->min = min;
+      repetition->max = max;
+      repetition->children.push_back(ast);
+      ast = repetition;
+    }
+    return ast;
+  }
+  size_t _number() {
+    size_t number = 0;
+    if (_end() || !std::isdigit(_peek())) _error("expected number");
+    while (!_end() && std::isdigit(_peek())) {
+      number = number * 10 + (_get() - '0');
+      if (number > maxRepetition) _error("too large repetition");
+    }
+    return number;
+  }
+  std::shared_ptr<Ast> _atom() {
+    auto c = _get();
+    switch (c) {
+      case '(': {
+        std::shared_ptr<Ast> ast;
+        if (_pattern.compare(_position, 2, "?:") == 0) {
+          _position += 2;
+          ast = _alternation();
+        } else {
+          ast        = newAst(Ast::GROUP);
+          ast->group = ++_nofGroups;
+          ast->children.push_back(_alternation());
+        }
+        if (_get() != ')') _error("expected )");
+        return ast;
+      }
+      case '*':
+      case '+':
+      case '?':
+      case '{': _error("nothing to repeat");
+      case '^':
+      case '$': _error("anchors are not supported");
+      case '[': return _class();
+      case '.': {
+        // like ECMAScript, line terminators are excluded
+        auto ast     = newAst(Ast::SET);
+        ast->symbols = ~(range('\n', '\n') | range('\r', '\r'));
+        return ast;
+      }
+      case '\\': {
+        auto ast     = newAst(Ast::SET);
+        ast->symbols = _escape();
+        return ast;
+      }
+      default: {
+        auto ast = newAst(Ast::SET);
+        ast->symbols.set(static_cast<uint8_t>(c));
+        return ast;
+      }
+    }
+  }
+  int _hex() {
+    auto c = _get();
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    _error("expected hexadecimal digit");
+    return 0;
+  }
+  Symbols _escape(bool inClass = false) {
+    auto const c = _get();
+    Symbols    symbols;
+    switch (c) {
+      case 'b':
+        if (inClass) return range('\b', '\b');
+        _error("word boundaries are not supported");
+      case 'B': _error("word boundaries are not supported");
+      case 'd': return range('0', '9');
+      case 'D': return ~range('0', '9');
+      case 'w':
+      case 'W':
+        symbols = range('a', 'z') | range('A', 'Z') | range('0', '9') |
+                  range('_', '_');
+        return c == 'w' ? symbols : ~symbols;
+      case 's':
+      case 'S':
+        symbols = range(' ', ' ') | range('\t', '\r');
+        return c == 's' ? symbols : ~symbols;
+      case 'n': return range('\n', '\n');
+      case 'r': return range('\r', '\r');
+      case 't': return range('\t', '\t');
+      case 'f': return range('\f', '\f');
+      case 'v': return range('\v', '\v');
+      case '0': return range(0, 0);
+      case 'x': {
+        auto const high = _hex();
+        auto const code = high * 16 + _hex();
+        return range(code, code);
+      }
+      default:
+        if (c >= '1' && c <= '9') _error("back references are not supported");
+        if (std::isalnum(static_cast<unsigned char>(c)))
+          _error("unsupported escape");
+        return range(static_cast<uint8_t>(c), static_cast<uint8_t>(c));
+    }
+  }
+  std::shared_ptr<Ast> _class() {
+    auto ast    = newAst(Ast::SET);
+    bool negate = !_end() && _peek() == '^';
+    if (negate) ++_position;
+    bool first = true;
+    while (_end() || _peek() != ']' || first) {
+      first       = false;
+      auto c      = _get();
+      auto single = true;
+      Symbols symbols;
+      if (c == '\\') {
+        symbols = _escape(true);
+        single  = symbols.count() == 1;
+        if (single) c = static_cast<char>(_firstSymbol(symbols));
+      } else
+        symbols.set(static_cast<uint8_t>(c));
+      if (single && _position + 1 < _pattern.size() && _peek() == '-' &&
+          _pattern[_position + 1] != ']') {
+        ++_position;
+        auto to = _get();
+        if (to == '\\') {
+          auto escaped = _escape(true);
+          if (escaped.count() != 1) _error("invalid range");
+          to = static_cast<char>(_firstSymbol(escaped));
+        }
+        auto const from = static_cast<uint8_t>(c);
+        if (static_cast<uint8_t>(to) < from) _error("invalid range");
+        symbols = range(from, static_cast<uint8_t>(to));
+      }
+      ast->symbols |= symbols;
+    }
+    ++_position;
+    if (negate) ast->symbols.flip();
+    return ast;
+  }
+  static size_t _firstSymbol(Symbols const& symbols) {
+    for (size_t s = 0; s < nofSymbols; ++s)
+      if (symbols[s]) return s;
+    return 0;
+  }
+  std::string const& _pattern;
+  size_t&            _nofGroups;
+  size_t             _position = 0;
+};
+
+/**
+ * @brief This structure represents node of Thompson NFA.
+ * Consuming node moves to next[0] using symbols, other nodes are epsilon
+ * nodes. Crossing an epsilon node with tag reports group boundary,
+ * tag is group * 2 + GroupBoundary.
+ */
+struct NfaNode {
+  Symbols             symbols;
+  bool                consumes = false;
+  std::vector<size_t> next;
+  size_t              tag   = none;
+  size_t              match = none;
+};
+
+struct Fragment {
+  size_t begin;
+  size_t end;
+};
+
+class Nfa {
+ public:
+  size_t add() {
+    // counted repetitions are expanded, nested ones grow exponentially
+    if (nodes.size() >= maxNfaNodes) {
+      std::stringstream ss;
+      ss << "MealyMachine::compileRegex - ";
+      ss << "NFA has more than " << maxNfaNodes << " nodes";
+      throw ex::Exception(ss.str());
+    }
+    nodes.emplace_back();
+    return nodes.size() - 1;
+  }
+  Fragment build(Ast const& ast) {
+    switch (ast.kind) {
+      case Ast::SET: {
+        auto const n       = add();
+        auto const e       = add();
+        nodes[n].consumes  = true;
+        nodes[n].symbols   = ast.symbols;
+        nodes[n].next      = {e};
+        return {n, e};
+      }
+      case Ast::CONCATENATION: {
+        auto const e = add();
+        Fragment   f = {e, e};
+        for (auto const& child : ast.children) {
+          auto const g = build(*child);
+          nodes[f.end].next.push_back(g.begin);
+          f.end = g.end;
+        }
+        return f;
+      }
+      case Ast::ALTERNATION: {
+        auto const s = add();
+        auto const e = add();
+        for (auto const& child : ast.children) {
+          auto const g = build(*child);
+          nodes[s].next.push_back(g.begin);
+          nodes[g.end].next.push_back(e);
+        }
+        return {s, e};
+      }
+      case Ast::REPETITION: {
+        auto const s   = add();
+        auto       end = s;
+        for (size_t i = 0; i < ast.min; ++i) {
+          auto const g = build(*ast.children[0]);
+          nodes[end].next.push_back(g.begin);
+          end = g.end;
+        }
+        auto const e = add();
+        if (ast.max == none) {
+          auto const g = build(*ast.children[0]);
+          nodes[end].next.push_back(g.begin);
+          nodes[end].next.push_back(e);
+          nodes[g.end].next.push_back(end);
+          return {s, e};
+        }
+        for (auto i = ast.min; i < ast.max; ++i) {
+          auto const g = build(*ast.children[0]);
+          nodes[end].next.push_back(g.begin);
+          nodes[end].next.push_back(e);
+          end = g.end;
+        }
+        nodes[end].next.push_back(e);
+        return {s, e};
+      }
+      case Ast::GROUP: {
+        auto const o  = add();
+        auto const g  = build(*ast.children[0]);
+        auto const c  = add();
+        nodes[o].tag  = ast.group * 2 + GROUP_BEGIN;
+        nodes[c].tag  = ast.group * 2 + GROUP_END;
+        nodes[o].next = {g.begin};
+        nodes[g.end].next.push_back(c);
+        return {o, c};
+      }
+    }
+    return {none, none};
+  }
+  /**
+   * @brief This function computes epsilon closure.
+   *
+   * @param seeds nodes that are reached by consuming a symbol
+   * @param closure sorted consuming and matching nodes of the closure
+   * @param tags sorted pairs of crossed tag and consuming or matching node
+   * of the closure that is reached after crossing the tag
+   */
+  void closure(std::vector<size_t> const& seeds,
+               std::vector<size_t>&       closure,
+               TagReach&                  tags) {
+    tags.clear();
+    tagNodes.clear();
+    walk(seeds, closure, &tagNodes);
+    for (auto const& t : tagNodes) {
+      walk({t}, afterTag, nullptr);
+      for (auto const& n : afterTag) tags.push_back({nodes[t].tag, n});
+    }
+    std::sort(tags.begin(), tags.end());
+    tags.erase(std::unique(tags.begin(), tags.end()), tags.end());
+  }
+  /**
+   * @brief This function finds consuming and matching nodes that are
+   * reachable from nodes using epsilon transitions.
+   *
+   * @param from nodes where the walk starts
+   * @param reached sorted reachable consuming and matching nodes
+   * @param tagged optional tag nodes that are crossed
+   */
+  void walk(std::vector<size_t> const& from, std::vector<size_t>& reached,
+            std::vector<size_t>* tagged) {
+    reached.clear();
+    if (visited.size() < nodes.size()) visited.resize(nodes.size(), 0);
+    ++generation;
+    stack.assign(from.begin(), from.end());
+    while (!stack.empty()) {
+      auto const n = stack.back();
+      stack.pop_back();
+      if (visited[n] == generation) continue;
+      visited[n]        = generation;
+      auto const& node = nodes[n];
+      if (node.tag != none && tagged) tagged->push_back(n);
+      if (node.consumes || node.match != none) reached.push_back(n);
+      if (node.consumes) continue;
+      for (auto const& next : node.next) stack.push_back(next);
+    }
+    std::sort(reached.begin(), reached.end());
+  }
+  std::vector<NfaNode> nodes;
+  std::vector<size_t>  visited;
+  std::vector<size_t>  stack;
+  std::vector<size_t>  tagNodes;
+  std::vector<size_t>  afterTag;
+  size_t               generation = 0;
+};
+
+/**
+ * @brief This structure represents state of DFA.
+ * Tags of the closure are reported by transition on symbol only if some
+ * consuming node of the symbol is reached after crossing them, and by EOF
+ * transition only if some matching node is reached.
+ */
+struct DfaState {
+  DfaState() {
+    target.fill(none);
+    events.fill(none);
+  }
+  std::vector<size_t>            nodes;
+  TagReach                       tags;
+  size_t                         accept    = none;
+  size_t                         eofEvents = 0;
+  std::array<size_t, nofSymbols> target;
+  std::array<size_t, nofSymbols> events;
+};
+
+/**
+ * @brief This function selects tags that lead to some of nodes.
+ *
+ * @param tags sorted pairs of tag and node reached after crossing it
+ * @param nodes sorted nodes
+ *
+ * @return sorted tags
+ */
+std::vector<size_t> tagsOf(TagReach const&            tags,
+                           std::vector<size_t> const& nodes) {
+  std::vector<size_t> result;
+  for (auto const& t : tags)
+    if ((result.empty() || result.back() != t.first) &&
+        std::binary_search(nodes.begin(), nodes.end(), t.second))
+      result.push_back(t.first);
+  return result;
+}
+
+MealyMachine::Callback eventCallback(std::vector<size_t> const& tags,
+                                     GroupCallback const&       onGroup) {
+  if (tags.empty() || !onGroup) return nullptr;
+  return [tags, onGroup](MealyMachine* machine) {
+    for (auto const& t : tags)
+      onGroup(machine, t / 2, static_cast<GroupBoundary>(t % 2),
+              machine->getReadingPosition());
+  };
+}
+
+}  // namespace
+
+MealyMachine mealyMachine::compileRegex(std::string const&   pattern,
+                                        GroupCallback const& onGroup) {
+  return compileRegex(std::vector<std::string>{pattern}, onGroup);
+}
+
+MealyMachine mealyMachine::compileRegex(
+    std::vector<std::string> const& patterns,
+    GroupCallback const&            onGroup) {
+  size_t nofGroups = 0;
+  Nfa    nfa;
+  auto   start = nfa.add();
+  for (size_t p = 0; p < patterns.size(); ++p) {
+    auto const ast   = Parser(patterns[p], nofGroups).parse();
+    auto const f     = nfa.build(*ast);
+    auto const match = nfa.add();
+    nfa.nodes[match].match = p;
+    nfa.nodes[f.end].next.push_back(match);
+    nfa.nodes[start].next.push_back(f.begin);
+  }
+
+  // subset construction, transitions report tags crossed before the
+  // consumed symbol
+  // states with equal closures differ if they cross different tags
+  std::vector<std::vector<size_t>>      eventLists(1);
+  std::map<std::vector<size_t>, size_t> eventIds = {{eventLists[0], 0}};
+  std::map<std::pair<std::vector<size_t>, TagReach>, size_t> stateIds;
+  std::vector<DfaState>                                      dfa;
+  std::vector<size_t>                                        nodes;
+  TagReach                                                   tags;
+  auto const internEvents = [&](std::vector<size_t> const& events) {
+    auto const inserted = eventIds.emplace(events, eventLists.size());
+    if (inserted.second) eventLists.push_back(events);
+    return inserted.first->second;
+  };
+  auto const addState = [&](std::vector<size_t> const& closure) {
+    DfaState            state;
+    std::vector<size_t> matching;
+    state.nodes = closure;
+    state.tags  = tags;
+    for (auto const& n : closure) {
+      if (nfa.nodes[n].match == none) continue;
+      state.accept = std::min(state.accept, nfa.nodes[n].match);
+      matching.push_back(n);
+    }
+    state.eofEvents = internEvents(tagsOf(tags, matching));
+    dfa.push_back(state);
+    if (dfa.size() > maxDfaStates) {
+      std::stringstream ss;
+      ss << "MealyMachine::compileRegex - ";
+      ss << "DFA has more than " << maxDfaStates << " states";
+      throw ex::Exception(ss.str());
+    }
+    return dfa.size() - 1;
+  };
+  nfa.closure({start}, nodes, tags);
+  addState(nodes);
+  std::map<std::vector<size_t>, std::vector<size_t>> moves;
+  std::vector<size_t>                                 moved;
+  for (size_t d = 0; d < dfa.size(); ++d) {
+    moves.clear();
+    for (size_t symbol = 0; symbol < nofSymbols; ++symbol) {
+      std::vector<size_t> consuming;
+      for (auto const& n : dfa[d].nodes)
+        if (nfa.nodes[n].consumes && nfa.nodes[n].symbols[symbol])
+          consuming.push_back(n);
+      moves[consuming].push_back(symbol);
+    }
+    for (auto const& move : moves) {
+      size_t target = none;
+      size_t events = 0;
+      if (!move.first.empty()) {
+        events = internEvents(tagsOf(dfa[d].tags, move.first));
+        moved.clear();
+        for (auto const& n : move.first)
+          moved.push_back(nfa.nodes[n].next[0]);
+        nfa.closure(moved, nodes, tags);
+        auto const inserted =
+            stateIds.emplace(std::make_pair(nodes, tags), dfa.size());
+        if (inserted.second) addState(nodes);
+        target = inserted.first->second;
+      }
+      for (auto const& symbol : move.second) {
+        dfa[d].target[symbol] = target;
+        dfa[d].events[symbol] = events;
+      }
+    }
+  }
+
+  // Moore minimization, transitions are distinguished by their events
+  std::vector<size_t> block(dfa.size());
+  size_t              nofBlocks = 0;
+  {
+    std::map<std::pair<size_t, size_t>, size_t> initial;
+    for (size_t d = 0; d < dfa.size(); ++d)
+      block[d] = initial
+                     .emplace(std::make_pair(dfa[d].accept, dfa[d].eofEvents),
+                              initial.size())
+                     .first->second;
+    nofBlocks = initial.size();
+  }
+  while (true) {
+    std::map<std::vector<size_t>, size_t> signatures;
+    std::vector<size_t>                   refined(dfa.size());
+    std::vector<size_t>                   signature;
+    for (size_t d = 0; d < dfa.size(); ++d) {
+      signature.assign(1, block[d]);
+      for (size_t symbol = 0; symbol < nofSymbols; ++symbol) {
+        auto const t = dfa[d].target[symbol];
+        signature.push_back(t == none ? none : block[t]);
+        signature.push_back(dfa[d].events[symbol]);
+      }
+      refined[d] =
+          signatures.emplace(signature, signatures.size()).first->second;
+    }
+    block.swap(refined);
+    if (signatures.size() == nofBlocks) break;
+    nofBlocks = signatures.size();
+  }
+
+  // blocks are numbered from the start state
+  std::vector<size_t> stateOf(nofBlocks, none);
+  std::vector<size_t> representatives = {0};
+  stateOf[block[0]]                   = 0;
+  for (size_t i = 0; i < representatives.size(); ++i)
+    for (auto const& t : dfa[representatives[i]].target) {
+      if (t == none || stateOf[block[t]] != none) continue;
+      stateOf[block[t]] = representatives.size();
+      representatives.push_back(t);
+    }
+
+  MealyMachine mm;
+  for (size_t s = 0; s < representatives.size(); ++s) mm.addState();
+  for (size_t s = 0; s < representatives.size(); ++s) {
+    auto const&                                         state =
+        dfa[representatives[s]];
+    std::map<std::pair<size_t, size_t>, std::string> transitions;
+    for (size_t symbol = 0; symbol < nofSymbols; ++symbol) {
+      if (state.target[symbol] == none) continue;
+      transitions[{stateOf[block[state.target[symbol]]], state.events[symbol]}]
+          .push_back(static_cast<char>(symbol));
+    }
+    for (auto const& t : transitions)
+      mm.addTransition(s, t.second, t.first.first,
+                       eventCallback(eventLists[t.first.second], onGroup));
+    if (state.accept == none) continue;
+    mm.addEOFTransition(s,
+                        eventCallback(eventLists[state.eofEvents], onGroup));
+    mm.setAccepting(s, static_cast<uint32_t>(state.accept));
+  }
+  mm.compile();
+  return mm;
+}
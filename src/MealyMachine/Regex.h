@@ -0,0 +1,80 @@
+/*!
+ * @file
+ * @brief This file contains regular expression front end of Mealy machine.
+ */
+
+#pragma once
+
+#include <MealyMachine/MealyMachine.h>
+
+namespace mealyMachine {
+
+/**
+ * @brief This enum distinguishes beginning and end of capture group.
+ */
+enum GroupBoundary {
+  GROUP_BEGIN = 0,
+  GROUP_END   = 1,
+};
+
+/**
+ * @brief This callback is called when matching crosses capture group
+ * boundary.
+ * Groups are numbered from 1 in order of their opening parentheses,
+ * position is position of the boundary in input stream.
+ */
+using GroupCallback = std::function<void(MealyMachine*  machine,
+                                         size_t         group,
+                                         GroupBoundary  boundary,
+                                         size_t         position)>;
+
+/**
+ * @brief This function compiles regular expression into Mealy machine.
+ * The pattern is parsed, Thompson NFA is built and converted into
+ * minimal DFA using subset construction. The DFA is returned as compiled
+ * Mealy machine whose match() is equivalent to std::regex_match
+ * (ECMAScript) for the supported syntax on byte strings.
+ * Supported syntax: literals, . (except \\n and \\r), [] classes with
+ * ranges and negation, \\d \\w \\s \\D \\W \\S \\n \\r \\t \\f \\v \\0
+ * \\xHH escapes, groups (), non-capturing groups (?:), alternation | and
+ * quantifiers * + ? {m} {m,} {m,n}. Symbols are bytes.
+ * Anchors ^ $, word boundaries \\b \\B, back references and other
+ * unsupported escapes throw ex::Exception. So do patterns whose counted
+ * repetitions exceed 1000, whose NFA exceeds 2^18 nodes or whose DFA
+ * exceeds 2^14 states.
+ * Accepting states are marked with kind 0, so the machine can be used
+ * by MealyMachine::lex too.
+ * Group boundaries are approximate: a boundary is reported when some path
+ * of the NFA crosses it and continues with the next symbol (or ends the
+ * match at EOF). Alternatives that do not accept the next symbol report
+ * nothing, but a path that accepts it and fails later still reports its
+ * boundaries, so a boundary can be reported several times or for a group
+ * that does not take part in the match. The last report before the end of
+ * match is the boundary of the longest match of its group.
+ *
+ * @param pattern regular expression
+ * @param onGroup optional callback of capture group boundaries
+ *
+ * @return compiled Mealy machine
+ */
+MEALYMACHINE_EXPORT MealyMachine compileRegex(std::string const&   pattern,
+                                              GroupCallback const& onGroup =
+                                                  nullptr);
+
+/**
+ * @brief This function compiles several regular expressions into one
+ * Mealy machine.
+ * Accepting states are marked with index of the first pattern that
+ * matches, so the machine can be used as longest match lexer.
+ * Groups are numbered across all patterns.
+ *
+ * @param patterns regular expressions
+ * @param onGroup optional callback of capture group boundaries
+ *
+ * @return compiled Mealy machine
+ */
+MEALYMACHINE_EXPORT MealyMachine
+compileRegex(std::vector<std::string> const& patterns,
+             GroupCallback const&            onGroup = nullptr);
+
+}  // namespace mealyMachine
@@ -0,0 +1,311 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MEALYMACHINE_MMAP
+#endif
+
+#include <MealyMachine/MealyMachine.h>
+#include <MealyMachine/Exception.h>
+
+using namespace mealyMachine;
+
+namespace {
+
+char const     fileMagic[8] = {'M', 'E', 'A', 'L', 'Y', 'M', 'M', '\0'};
+uint32_t const fileVersion  = 1;
+uint32_t const byteOrder    = 0x01020304u;
+size_t const   fileAlign    = 64;
+
+/**
+ * @brief This structure is stored at the beginning of the file.
+ * Offsets are relative to the beginning of the file and aligned to
+ * fileAlign bytes.
+ */
+struct FileHeader {
+  char     magic[8];
+  uint32_t version;
+  uint32_t byteOrder;
+  uint64_t nofStates;
+  uint64_t nofClasses;
+  uint64_t nofActions;
+  uint64_t nofInstructions;
+  uint64_t transitions;
+  uint64_t eofTransitions;
+  uint64_t loops;
+  uint64_t classes;
+  uint64_t accepting;
+  uint64_t actions;
+  uint64_t code;
+  uint64_t size;
+};
+
+/**
+ * @brief This structure represents token marks, kind and program of one
+ * action.
+ */
+struct FileAction {
+  uint32_t tokenKind;
+  uint32_t tokenAfterKind;
+  uint32_t codeBegin;
+  uint32_t codeSize;
+  uint8_t  tokenMarks;
+  uint8_t  padding[3];
+};
+
+/**
+ * @brief This structure represents one instruction of action program.
+ */
+struct FileInstruction {
+  uint32_t opcode;
+  uint32_t operand;
+};
+
+size_t alignUp(size_t offset) {
+  return (offset + fileAlign - 1) / fileAlign * fileAlign;
+}
+
+[[noreturn]] void throwFileError(std::string const& where,
+                                 std::string const& path,
+                                 std::string const& what) {
+  std::stringstream ss;
+  ss << "MealyMachine::" << where << "(" << path << ") - " << what;
+  throw ex::Exception(ss.str());
+}
+
+/**
+ * @brief This function maps whole file read-only or reads it into memory if
+ * memory mapping is not available.
+ *
+ * @param path path of the file
+ * @param size size of the file
+ *
+ * @return memory of the file, it is unmapped or freed with the last copy
+ */
+std::shared_ptr<void const> mapFile(std::string const& path, size_t& size) {
+#if defined(MEALYMACHINE_MMAP)
+  auto const fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) throwFileError("load", path, "file cannot be opened");
+  struct stat info;
+  if (::fstat(fd, &info) != 0 || info.st_size == 0) {
+    ::close(fd);
+    throwFileError("load", path, "file is empty");
+  }
+  size         = static_cast<size_t>(info.st_size);
+  auto address = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (address == MAP_FAILED)
+    throwFileError("load", path, "file cannot be mapped");
+  return std::shared_ptr<void const>(
+      address, [size](void const* a) { ::munmap(const_cast<void*>(a), size); });
+#else
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (!file) throwFileError("load", path, "file cannot be opened");
+  size = static_cast<size_t>(file.tellg());
+  // uint64_t keeps tables aligned
+  std::shared_ptr<uint64_t> data(new uint64_t[size / sizeof(uint64_t) + 1],
+                                 std::default_delete<uint64_t[]>());
+  file.seekg(0);
+  if (!file.read(reinterpret_cast<char*>(data.get()), size))
+    throwFileError("load", path, "file cannot be read");
+  return data;
+#endif
+}
+
+}  // namespace
+
+void MealyMachine::save(std::string const& path) const {
+  _throwIfNotCompiled("save(" + path + ")");
+  auto const& compiled = _definition->compiled;
+  auto const& actions  = _definition->actions;
+  auto const& code     = _definition->code;
+
+  FileHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, fileMagic, sizeof(fileMagic));
+  header.version    = fileVersion;
+  header.byteOrder  = byteOrder;
+  header.nofStates  = compiled.nofStates;
+  header.nofClasses = compiled.nofClasses;
+  header.nofActions = actions.size();
+  header.nofInstructions = code.size();
+  auto const nofCells = compiled.nofStates * compiled.nofClasses;
+  auto const nofStates = compiled.nofStates;
+  header.transitions = alignUp(sizeof(FileHeader));
+  header.eofTransitions =
+      alignUp(header.transitions + nofCells * sizeof(CompiledTransition));
+  header.loops =
+      alignUp(header.eofTransitions + nofStates * sizeof(CompiledTransition));
+  header.classes = alignUp(header.loops + nofStates * sizeof(CompiledLoop));
+  header.accepting = alignUp(header.classes + compiledSymbols);
+  header.actions = alignUp(header.accepting + nofStates * sizeof(uint32_t));
+  header.code = alignUp(header.actions + actions.size() * sizeof(FileAction));
+  header.size = header.code + code.size() * sizeof(FileInstruction);
+
+  std::vector<FileAction> fileActions(actions.size());
+  for (size_t a = 0; a < actions.size(); ++a) {
+    std::memset(&fileActions[a], 0, sizeof(FileAction));
+    fileActions[a].tokenKind      = actions[a].tokenKind;
+    fileActions[a].tokenAfterKind = actions[a].tokenAfterKind;
+    fileActions[a].tokenMarks     = actions[a].tokenMarks;
+    fileActions[a].codeBegin      = actions[a].codeBegin;
+    fileActions[a].codeSize       = actions[a].codeSize;
+  }
+  std::vector<FileInstruction> fileCode(code.size());
+  for (size_t i = 0; i < code.size(); ++i)
+    fileCode[i] = {code[i].opcode, code[i].operand};
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file) throwFileError("save", path, "file cannot be created");
+  auto write = [&](uint64_t offset, void const* data, size_t size) {
+    static char const zeros[fileAlign] = {};
+    auto const        position         = static_cast<uint64_t>(file.tellp());
+    file.write(zeros, static_cast<std::streamsize>(offset - position));
+    file.write(static_cast<char const*>(data),
+               static_cast<std::streamsize>(size));
+  };
+  write(0, &header, sizeof(header));
+  write(header.transitions, compiled.transitions,
+        nofCells * sizeof(CompiledTransition));
+  write(header.eofTransitions, compiled.eofTransitions,
+        nofStates * sizeof(CompiledTransition));
+  write(header.loops, compiled.loops, nofStates * sizeof(CompiledLoop));
+  write(header.classes, compiled.classes, compiledSymbols);
+  write(header.accepting, compiled.accepting, nofStates * sizeof(uint32_t));
+  write(header.actions, fileActions.data(),
+        fileActions.size() * sizeof(FileAction));
+  write(header.code, fileCode.data(),
+        fileCode.size() * sizeof(FileInstruction));
+  if (!file) throwFileError("save", path, "file cannot be written");
+}
+
+MealyMachine MealyMachine::load(std::string const& path) {
+  size_t     size = 0;
+  auto const file = mapFile(path, size);
+  auto const data = static_cast<uint8_t const*>(file.get());
+
+  FileHeader header;
+  if (size < sizeof(header)) throwFileError("load", path, "file is too small");
+  std::memcpy(&header, data, sizeof(header));
+  if (std::memcmp(header.magic, fileMagic, sizeof(fileMagic)) != 0)
+    throwFileError("load", path, "file is not Mealy machine");
+  if (header.byteOrder != byteOrder)
+    throwFileError("load", path, "file has different byte order");
+  if (header.version != fileVersion) {
+    std::stringstream ss;
+    ss << "unsupported version " << header.version;
+    throwFileError("load", path, ss.str());
+  }
+  auto const section = [&](uint64_t offset, uint64_t count, size_t itemSize) {
+    if (offset % fileAlign != 0 || offset > size ||
+        count > (size - offset) / itemSize)
+      throwFileError("load", path, "file is corrupted");
+  };
+  if (header.nofStates == 0 || header.nofStates >= nonexistingCompiledState ||
+      header.nofClasses == 0 || header.nofClasses > compiledSymbols ||
+      header.nofActions >= noCompiledAction ||
+      header.nofInstructions >= noCompiledAction || header.size != size)
+    throwFileError("load", path, "file is corrupted");
+  section(header.transitions, header.nofStates * header.nofClasses,
+          sizeof(CompiledTransition));
+  section(header.eofTransitions, header.nofStates, sizeof(CompiledTransition));
+  section(header.loops, header.nofStates, sizeof(CompiledLoop));
+  section(header.classes, compiledSymbols, 1);
+  section(header.accepting, header.nofStates, sizeof(uint32_t));
+  section(header.actions, header.nofActions, sizeof(FileAction));
+  section(header.code, header.nofInstructions, sizeof(FileInstruction));
+
+  MealyMachine mm;
+  auto&        definition = *mm._editable;
+  auto const*  actions =
+      reinterpret_cast<FileAction const*>(data + header.actions);
+  auto const* code =
+      reinterpret_cast<FileInstruction const*>(data + header.code);
+  definition.code.resize(header.nofInstructions);
+  for (size_t i = 0; i < header.nofInstructions; ++i) {
+    auto const usesSlot =
+        code[i].opcode == OP_INC || code[i].opcode == OP_MARK;
+    if (code[i].opcode > OP_EMIT || (usesSlot && code[i].operand >= maxSlots))
+      throwFileError("load", path, "file is corrupted");
+    definition.code[i] = {static_cast<Opcode>(code[i].opcode),
+                          code[i].operand};
+    if (usesSlot)
+      definition.nofSlots = std::max(definition.nofSlots, code[i].operand + 1);
+  }
+  definition.actions.resize(header.nofActions);
+  for (size_t a = 0; a < header.nofActions; ++a) {
+    if (actions[a].codeBegin > header.nofInstructions ||
+        actions[a].codeSize > header.nofInstructions - actions[a].codeBegin)
+      throwFileError("load", path, "file is corrupted");
+    definition.actions[a].tokenKind      = actions[a].tokenKind;
+    definition.actions[a].tokenAfterKind = actions[a].tokenAfterKind;
+    definition.actions[a].tokenMarks     = actions[a].tokenMarks;
+    definition.actions[a].codeBegin      = actions[a].codeBegin;
+    definition.actions[a].codeSize       = actions[a].codeSize;
+  }
+  auto& compiled       = definition.compiled;
+  compiled.transitions = reinterpret_cast<CompiledTransition const*>(
+      data + header.transitions);
+  compiled.eofTransitions = reinterpret_cast<CompiledTransition const*>(
+      data + header.eofTransitions);
+  compiled.loops =
+      reinterpret_cast<CompiledLoop const*>(data + header.loops);
+  compiled.classes   = data + header.classes;
+  compiled.accepting =
+      reinterpret_cast<uint32_t const*>(data + header.accepting);
+  compiled.nofStates  = static_cast<size_t>(header.nofStates);
+  compiled.nofClasses = static_cast<size_t>(header.nofClasses);
+  definition.file     = file;
+  mm._slots.resize(definition.nofSlots, 0);
+
+  return mm;
+}
+
+void MealyMachine::verify() const {
+  _throwIfNotCompiled("verify()");
+  auto const& compiled   = _definition->compiled;
+  auto const  nofActions = _definition->actions.size();
+  auto const  corrupted  = [] {
+    std::stringstream ss;
+    ss << "MealyMachine::verify() - compiled table is corrupted";
+    throw ex::Exception(ss.str());
+  };
+  // parse loops index tables by cell contents without checks
+  auto const validCell = [&](CompiledTransition const& t) {
+    return (t.state < compiled.nofStates ||
+            t.state == nonexistingCompiledState) &&
+           (t.action < nofActions || t.action == noCompiledAction);
+  };
+  for (size_t i = 0; i < compiledSymbols; ++i)
+    if (compiled.classes[i] >= compiled.nofClasses) corrupted();
+  for (size_t i = 0; i < compiled.nofStates * compiled.nofClasses; ++i)
+    if (!validCell(compiled.transitions[i])) corrupted();
+  for (size_t s = 0; s < compiled.nofStates; ++s) {
+    auto const loop = _computeLoop(
+        compiled.transitions + s * compiled.nofClasses, compiled.classes, s);
+    if (!validCell(compiled.eofTransitions[s]) ||
+        std::memcmp(&loop, compiled.loops + s, sizeof(CompiledLoop)) != 0)
+      corrupted();
+  }
+}
+
+size_t MealyMachine::getNofActions() const {
+  return _definition->actions.size();
+}
+
+void MealyMachine::bindAction(size_t action, Callback const& callback) {
+  auto& definition = _edit("bindAction");
+  if (action >= definition.actions.size()) {
+    std::stringstream ss;
+    ss << "MealyMachine::bindAction(" << action << ")";
+    ss << " - action does not exist";
+    throw ex::Exception(ss.str());
+  }
+  definition.actions[action].callback = callback;
+}
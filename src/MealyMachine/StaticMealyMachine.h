@@ -0,0 +1,300 @@
+/*!
+ * @file
+ * @brief This file contains compile-time definition of compiled Mealy
+ * machine.
+ */
+
+#pragma once
+
+#include <MealyMachine/Exception.h>
+#include <MealyMachine/MealyMachine.h>
+
+/**
+ * @brief This class contains compiled tables of Mealy machine.
+ * It is created by StaticMealyMachineBuilder::compile during constant
+ * evaluation, so a static constexpr instance is stored in read-only data
+ * and shared by processes like any other constant.
+ * nofStates is number of states, nofClasses is maximal number of symbol
+ * classes, transitions have room for nofStates x nofClasses cells.
+ */
+template <size_t nofStates, size_t nofClasses>
+class mealyMachine::StaticMealyMachine {
+  static_assert(nofStates > 0 &&
+                    nofStates < MealyMachine::nonexistingCompiledState,
+                "StaticMealyMachine needs 1 to 2^32-2 states");
+  static_assert(nofClasses > 0 && nofClasses <= MealyMachine::compiledSymbols,
+                "StaticMealyMachine supports 1 to 256 symbol classes");
+
+ public:
+  constexpr StaticMealyMachine() {}
+
+  /**
+   * @brief This function returns number of used symbol classes.
+   *
+   * @return number of columns of the table
+   */
+  constexpr size_t getNofClasses() const { return _nofClasses; }
+
+  /**
+   * @brief This function returns number of actions.
+   *
+   * @return largest action id + 1
+   */
+  constexpr size_t getNofActions() const { return _nofActions; }
+
+  /**
+   * @brief This function creates compiled Mealy machine that parses
+   * directly from tables of this object, the tables are not copied.
+   * The object has to outlive the machine, so it should be static.
+   * Callbacks are bound using MealyMachine::bindAction.
+   * The machine allocates its definition and actions on heap, cursor
+   * BasicMealyMachine constructed from this object does not allocate.
+   *
+   * @return compiled Mealy machine
+   */
+  MealyMachine machine() const;
+
+ protected:
+  template <size_t>
+  friend class StaticMealyMachineBuilder;
+  template <typename>
+  friend class BasicMealyMachine;
+  using CompiledTransition = MealyMachine::CompiledTransition;
+  using CompiledLoop       = MealyMachine::CompiledLoop;
+  CompiledTransition _transitions[nofStates * nofClasses]    = {};
+  CompiledTransition _eofTransitions[nofStates]              = {};
+  CompiledLoop       _loops[nofStates]                       = {};
+  uint8_t            _classes[MealyMachine::compiledSymbols] = {};
+  uint32_t           _accepting[nofStates]                   = {};
+  size_t             _nofClasses                             = 0;
+  size_t             _nofActions                             = 0;
+};
+
+/**
+ * @brief This class builds compiled tables of Mealy machine using constexpr
+ * functions.
+ * States are numbered 0..nofStates-1, 0 is start state. Actions are ids
+ * chosen by the caller, callbacks are bound to them at runtime.
+ * The builder is filled by constexpr function and compiled into constant,
+ * number of symbol classes can be computed first:
+ * @code
+ * constexpr mealyMachine::StaticMealyMachineBuilder<2> numberBuilder() {
+ *   mealyMachine::StaticMealyMachineBuilder<2> b;
+ *   b.addTransition(0, '0', '9', 1, 0);
+ *   b.addTransition(1, '0', '9', 1);
+ *   b.addEOFTransition(1);
+ *   return b;
+ * }
+ * constexpr auto builder = numberBuilder();
+ * static constexpr auto number = builder.compile<builder.getNofClasses()>();
+ * @endcode
+ * Errors throw ex::Exception, so they are compile errors during constant
+ * evaluation.
+ */
+template <size_t nofStates>
+class mealyMachine::StaticMealyMachineBuilder {
+ public:
+  using StateIndex  = uint32_t;
+  using ActionIndex = uint32_t;
+  static const ActionIndex noAction = MealyMachine::noCompiledAction;
+
+  constexpr StaticMealyMachineBuilder() {
+    for (size_t s = 0; s < nofStates; ++s) {
+      for (size_t symbol = 0; symbol < MealyMachine::compiledSymbols; ++symbol)
+        _cells[s * MealyMachine::compiledSymbols + symbol] = _none();
+      _else[s]      = _none();
+      _eof[s]       = _none();
+      _accepting[s] = MealyMachine::notAccepting;
+    }
+  }
+
+  /**
+   * @brief This function adds transitions for every symbol of string.
+   *
+   * @param from id of start state
+   * @param symbols zero terminated string of symbols
+   * @param to id of end state
+   * @param action id of action or noAction
+   */
+  constexpr void addTransition(StateIndex  from,
+                               char const* symbols,
+                               StateIndex  to,
+                               ActionIndex action = noAction) {
+    for (; *symbols; ++symbols) {
+      auto const symbol = static_cast<uint8_t>(*symbols);
+      _set(from, symbol, symbol, to, action);
+    }
+  }
+
+  /**
+   * @brief This function adds transitions for range of symbols.
+   *
+   * @param from id of start state
+   * @param symbolFrom first symbol of the range
+   * @param symbolTo last symbol of the range
+   * @param to id of end state
+   * @param action id of action or noAction
+   */
+  constexpr void addTransition(StateIndex  from,
+                               char        symbolFrom,
+                               char        symbolTo,
+                               StateIndex  to,
+                               ActionIndex action = noAction) {
+    _set(from, static_cast<uint8_t>(symbolFrom),
+         static_cast<uint8_t>(symbolTo), to, action);
+  }
+
+  /**
+   * @brief This function adds else transition.
+   * It is used for symbols without transition in "from" state.
+   *
+   * @param from id of start state
+   * @param to id of end state
+   * @param action id of action or noAction
+   */
+  constexpr void addElseTransition(StateIndex  from,
+                                   StateIndex  to,
+                                   ActionIndex action = noAction) {
+    _check(from, to, action);
+    _else[from] = {to, action};
+  }
+
+  /**
+   * @brief This function adds EOF transition.
+   *
+   * @param from id of start state
+   * @param action id of action or noAction
+   */
+  constexpr void addEOFTransition(StateIndex from,
+                                  ActionIndex action = noAction) {
+    _check(from, 0, action);
+    _eof[from] = {0, action};
+  }
+
+  /**
+   * @brief This function marks state as accepting state of lexer.
+   *
+   * @param state id of state
+   * @param kind token kind
+   */
+  constexpr void setAccepting(StateIndex state, uint32_t kind) {
+    _check(state, 0, noAction);
+    _accepting[state] = kind;
+  }
+
+  /**
+   * @brief This function returns number of distinct symbol classes.
+   * It can be used to choose the smallest table for compile.
+   *
+   * @return number of symbol classes
+   */
+  constexpr size_t getNofClasses() const {
+    size_t  nofClassesUsed                                 = 0;
+    uint8_t representatives[MealyMachine::compiledSymbols] = {};
+    _classify(nullptr, representatives, nofClassesUsed);
+    return nofClassesUsed;
+  }
+
+  /**
+   * @brief This function lowers the machine into compiled tables.
+   * Symbols that behave the same way in all states share one symbol class.
+   *
+   * @tparam nofClasses maximal number of symbol classes, it throws if the
+   * machine needs more classes
+   *
+   * @return compiled tables
+   */
+  template <size_t nofClasses = MealyMachine::compiledSymbols>
+  constexpr StaticMealyMachine<nofStates, nofClasses> compile() const {
+    StaticMealyMachine<nofStates, nofClasses> result;
+    size_t  nofClassesUsed                                 = 0;
+    uint8_t representatives[MealyMachine::compiledSymbols] = {};
+    _classify(result._classes, representatives, nofClassesUsed);
+    if (nofClassesUsed > nofClasses)
+      throw ex::Exception(
+          "MealyMachine::StaticMealyMachineBuilder::compile - "
+          "machine needs more symbol classes");
+    for (size_t s = 0; s < nofStates; ++s) {
+      for (size_t c = 0; c < nofClassesUsed; ++c)
+        result._transitions[s * nofClassesUsed + c] =
+            _cell(s, representatives[c]);
+      result._eofTransitions[s] = _eof[s];
+      result._accepting[s]      = _accepting[s];
+    }
+    for (size_t s = 0; s < nofStates; ++s)
+      result._loops[s] = MealyMachine::_computeLoop(
+          result._transitions + s * nofClassesUsed, result._classes, s);
+    result._nofClasses = nofClassesUsed;
+    result._nofActions = _nofActions;
+    return result;
+  }
+
+ protected:
+  using CompiledTransition = MealyMachine::CompiledTransition;
+  static constexpr CompiledTransition _none() {
+    return {MealyMachine::nonexistingCompiledState, noAction};
+  }
+  constexpr void _check(StateIndex from, StateIndex to, ActionIndex action) {
+    if (from >= nofStates || to >= nofStates)
+      throw ex::Exception(
+          "MealyMachine::StaticMealyMachineBuilder - state does not exist");
+    if (action != noAction && action >= _nofActions) _nofActions = action + 1;
+  }
+  constexpr void _set(StateIndex  from,
+                      uint8_t     symbolFrom,
+                      uint8_t     symbolTo,
+                      StateIndex  to,
+                      ActionIndex action) {
+    _check(from, to, action);
+    for (size_t symbol = symbolFrom; symbol <= symbolTo; ++symbol)
+      _cells[from * MealyMachine::compiledSymbols + symbol] = {to, action};
+  }
+  constexpr CompiledTransition _cell(size_t state, size_t symbol) const {
+    auto const& cell = _cells[state * MealyMachine::compiledSymbols + symbol];
+    if (cell.state != MealyMachine::nonexistingCompiledState) return cell;
+    return _else[state];
+  }
+  constexpr bool _sameColumn(size_t a, size_t b) const {
+    for (size_t s = 0; s < nofStates; ++s) {
+      auto const x = _cell(s, a);
+      auto const y = _cell(s, b);
+      if (x.state != y.state || x.action != y.action) return false;
+    }
+    return true;
+  }
+  // classes can be nullptr if only number of classes is needed
+  constexpr void _classify(uint8_t* classes,
+                           uint8_t* representatives,
+                           size_t&  nofClassesUsed) const {
+    for (size_t symbol = 0; symbol < MealyMachine::compiledSymbols; ++symbol) {
+      size_t c = 0;
+      while (c < nofClassesUsed && !_sameColumn(representatives[c], symbol))
+        ++c;
+      if (c == nofClassesUsed)
+        representatives[nofClassesUsed++] = static_cast<uint8_t>(symbol);
+      if (classes) classes[symbol] = static_cast<uint8_t>(c);
+    }
+  }
+  CompiledTransition _cells[nofStates * MealyMachine::compiledSymbols] = {};
+  CompiledTransition _else[nofStates]                                 = {};
+  CompiledTransition _eof[nofStates]                                  = {};
+  uint32_t           _accepting[nofStates]                            = {};
+  size_t             _nofActions                                      = 0;
+};
+
+template <size_t nofStates, size_t nofClasses>
+mealyMachine::MealyMachine
+mealyMachine::StaticMealyMachine<nofStates, nofClasses>::machine() const {
+  MealyMachine mm;
+  auto&        definition = *mm._editable;
+  definition.actions.resize(_nofActions);
+  auto& compiled          = definition.compiled;
+  compiled.transitions    = _transitions;
+  compiled.eofTransitions = _eofTransitions;
+  compiled.loops          = _loops;
+  compiled.classes        = _classes;
+  compiled.accepting      = _accepting;
+  compiled.nofStates      = nofStates;
+  compiled.nofClasses     = _nofClasses;
+  return mm;
+}
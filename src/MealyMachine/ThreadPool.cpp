@@ -0,0 +1,118 @@
+#include <algorithm>
+
+#include <MealyMachine/ThreadPool.h>
+
+using namespace mealyMachine;
+
+ThreadPool::ThreadPool(size_t workers) {
+  if (workers == 0)
+    workers = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  _nofWorkers = workers;
+  _ranges.reset(new Range[workers]);
+  for (size_t w = 1; w < workers; ++w)
+    _threads.emplace_back([this, w] { _loop(w); });
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stop = true;
+  }
+  _start.notify_all();
+  for (auto& thread : _threads) thread.join();
+}
+
+size_t ThreadPool::getNofWorkers() const { return _nofWorkers; }
+
+void ThreadPool::parallelFor(size_t count, size_t grain, Task const& task) {
+  if (count == 0) return;
+  for (size_t w = 0; w < _nofWorkers; ++w) {
+    std::lock_guard<std::mutex> lock(_ranges[w].mutex);
+    _ranges[w].begin = count * w / _nofWorkers;
+    _ranges[w].end   = count * (w + 1) / _nofWorkers;
+  }
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _task      = &task;
+    _grain     = std::max<size_t>(grain, 1);
+    _running   = _nofWorkers - 1;
+    _exception = nullptr;
+    ++_generation;
+  }
+  _start.notify_all();
+  _work(0);
+  std::unique_lock<std::mutex> lock(_mutex);
+  _done.wait(lock, [this] { return _running == 0; });
+  _task = nullptr;
+  if (_exception) std::rethrow_exception(_exception);
+}
+
+void ThreadPool::_loop(size_t worker) {
+  size_t generation = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _start.wait(lock,
+                  [&] { return _stop || _generation != generation; });
+      if (_stop) return;
+      generation = _generation;
+    }
+    _work(worker);
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (--_running == 0) _done.notify_one();
+  }
+}
+
+void ThreadPool::_work(size_t worker) {
+  size_t begin;
+  size_t end;
+  while (_next(worker, begin, end)) {
+    try {
+      (*_task)(worker, begin, end);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (!_exception) _exception = std::current_exception();
+    }
+  }
+}
+
+/**
+ * @brief This function takes next chunk of worker.
+ * If worker has no indices left, it steals the second half of indices of
+ * the first worker that has some.
+ *
+ * @param worker worker id
+ * @param begin first index of chunk
+ * @param end index behind the chunk
+ *
+ * @return false if there are no indices left in any worker
+ */
+bool ThreadPool::_next(size_t worker, size_t& begin, size_t& end) {
+  auto& own = _ranges[worker];
+  for (size_t i = 0; i < _nofWorkers; ++i) {
+    auto& victim = _ranges[(worker + i) % _nofWorkers];
+    size_t stolenBegin;
+    size_t stolenEnd;
+    {
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      auto const remaining = victim.end - victim.begin;
+      if (remaining == 0) continue;
+      if (i == 0 || remaining <= _grain) {
+        begin        = victim.begin;
+        end          = std::min(victim.begin + _grain, victim.end);
+        victim.begin = end;
+        return true;
+      }
+      stolenBegin = victim.begin + remaining / 2;
+      stolenEnd   = victim.end;
+      victim.end  = stolenBegin;
+    }
+    std::lock_guard<std::mutex> lock(own.mutex);
+    begin     = stolenBegin;
+    end       = std::min(stolenBegin + _grain, stolenEnd);
+    own.begin = end;
+    own.end   = stolenEnd;
+    return true;
+  }
+  return false;
+}
@@ -0,0 +1,86 @@
+/*!
+ * @file
+ * @brief This file contains work-stealing thread pool used by batch
+ * matching.
+ */
+
+#pragma once
+
+#include <MealyMachine/Fwd.h>
+#include <MealyMachine/mealymachine_export.h>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief This class represents pool of threads that processes index ranges.
+ * The calling thread is worker 0, the pool starts getNofWorkers()-1
+ * threads. Every worker gets one part of the index range and takes small
+ * chunks from its front; when its part is empty, it steals half of the
+ * remaining part of another worker.
+ */
+class mealyMachine::ThreadPool {
+ public:
+  using Task = std::function<void(size_t worker, size_t begin, size_t end)>;
+
+  /**
+   * @brief This constructor starts worker threads.
+   *
+   * @param workers number of workers including calling thread,
+   * 0 means number of hardware threads
+   */
+  MEALYMACHINE_EXPORT ThreadPool(size_t workers = 0);
+  MEALYMACHINE_EXPORT ~ThreadPool();
+  ThreadPool(ThreadPool const&) = delete;
+  ThreadPool& operator=(ThreadPool const&) = delete;
+
+  /**
+   * @brief This function returns number of workers including calling thread.
+   *
+   * @return number of workers
+   */
+  MEALYMACHINE_EXPORT size_t getNofWorkers() const;
+
+  /**
+   * @brief This function calls task for chunks of range [0, count) in
+   * parallel and waits until all chunks are done.
+   * Only one parallelFor can run at a time. If a task throws, the first
+   * exception is rethrown after all chunks are done.
+   *
+   * @param count number of indices
+   * @param grain maximal number of indices in one chunk
+   * @param task task that is called with worker id and chunk
+   */
+  MEALYMACHINE_EXPORT void parallelFor(size_t      count,
+                                       size_t      grain,
+                                       Task const& task);
+
+ protected:
+  /**
+   * @brief This structure represents indices that are owned by one worker.
+   */
+  struct Range {
+    std::mutex mutex;
+    size_t     begin = 0;
+    size_t     end   = 0;
+  };
+  void                     _loop(size_t worker);
+  void                     _work(size_t worker);
+  bool                     _next(size_t worker, size_t& begin, size_t& end);
+  size_t                   _nofWorkers;
+  std::unique_ptr<Range[]> _ranges;
+  std::vector<std::thread> _threads;
+  std::mutex               _mutex;
+  std::condition_variable  _start;
+  std::condition_variable  _done;
+  Task const*              _task       = nullptr;
+  size_t                   _grain      = 1;
+  size_t                   _generation = 0;
+  size_t                   _running    = 0;
+  bool                     _stop       = false;
+  std::exception_ptr       _exception;
+};
@@ -12,6 +12,11 @@ class mealyMachine::TransitionChooser {
   virtual bool addTransition(MealyMachine::TransitionSymbol const& data) = 0;
   virtual MealyMachine::TransitionSymbol const& getSymbol(
       MealyMachine::TransitionIndex const& index) const = 0;
+  virtual inline bool addTransitionRange(
+      MealyMachine::TransitionSymbol const& from,
+      MealyMachine::TransitionSymbol const& to);
+  virtual inline MealyMachine::TransitionSymbol const& getLastSymbol(
+      MealyMachine::TransitionIndex const& index) const;
 
  protected:
   size_t _size;
@@ -26,3 +31,33 @@ inline mealyMachine::TransitionChooser::~TransitionChooser() {}
 inline size_t mealyMachine::TransitionChooser::getSize() const {
   return _size;
 }
+
+/**
+ * @brief This function adds one transition for whole range of symbols.
+ * Transition choosers that do not store ranges return false and Mealy machine
+ * adds every symbol of the range separately.
+ *
+ * @param from first symbol of the range
+ * @param to last symbol of the range
+ *
+ * @return true if the range was added as one transition
+ */
+inline bool mealyMachine::TransitionChooser::addTransitionRange(
+    MealyMachine::TransitionSymbol const&,
+    MealyMachine::TransitionSymbol const&) {
+  return false;
+}
+
+/**
+ * @brief This function returns the last symbol of transition.
+ * It differs from getSymbol only for transitions that were added as ranges.
+ *
+ * @param index transition index
+ *
+ * @return last symbol of transition
+ */
+inline mealyMachine::MealyMachine::TransitionSymbol const&
+mealyMachine::TransitionChooser::getLastSymbol(
+    MealyMachine::TransitionIndex const& index) const {
+  return getSymbol(index);
+}
@@ -0,0 +1,262 @@
+#include<catch.hpp>
+
+#include<MealyMachine/MealyMachine.h>
+#include<MealyMachine/MapTransitionChooser.h>
+#include<MealyMachine/BasicMealyMachine.h>
+#include<MealyMachine/StaticMealyMachine.h>
+#include<MealyMachine/Exception.h>
+#include<MealyMachine/ThreadPool.h>
+
+#include<algorithm>
+#include<atomic>
+#include<cstdlib>
+#include<new>
+#include<string>
+#include<vector>
+
+using namespace mealyMachine;
+
+//This file replaces global operator new and counts allocations
+//that happen between begin and end of counted section.
+namespace{
+  std::atomic<bool  >counting   (false);
+  std::atomic<size_t>allocations(0    );
+
+  class CountAllocations{
+    public:
+      CountAllocations(){allocations = 0;counting = true;}
+      ~CountAllocations(){counting = false;}
+      size_t get()const{return allocations;}
+  };
+}
+
+void*operator new(std::size_t size){
+  if(counting)allocations++;
+  if(auto ptr = std::malloc(size ? size : 1))return ptr;
+  throw std::bad_alloc();
+}
+
+void*operator new[](std::size_t size){
+  return operator new(size);
+}
+
+void operator delete(void*ptr)noexcept{
+  std::free(ptr);
+}
+
+void operator delete[](void*ptr)noexcept{
+  std::free(ptr);
+}
+
+void operator delete(void*ptr,std::size_t)noexcept{
+  std::free(ptr);
+}
+
+void operator delete[](void*ptr,std::size_t)noexcept{
+  std::free(ptr);
+}
+
+SCENARIO("parsing does not allocate"){
+  //large captures do not fit into small buffer of std::function
+  size_t counters[16] = {};
+  auto counter = [counters](MealyMachine*)mutable{counters[0]++;};
+
+  MealyMachine mm;
+  auto S = mm.addState();
+  auto P = mm.addState();
+  auto M = mm.addState();
+  auto E = mm.addState();
+  mm.addTransition    (S,"+",P);
+  mm.addTransition    (S,"-",M);
+  mm.addElseTransition(S    ,E,counter);
+  mm.addEOFTransition (S);
+  mm.addTransition    (P,"+",S,counter);
+  mm.addTransition    (P,"-",M,counter);
+  mm.addElseTransition(P,    S,[&](MealyMachine*m){m->dontMove();counter(m);});
+  mm.addEOFTransition (P,      counter);
+  mm.addTransition    (M,"-",S,counter);
+  mm.addTransition    (M,"+",P,counter);
+  mm.addElseTransition(M,    S,[&](MealyMachine*m){m->dontMove();counter(m);});
+  mm.addEOFTransition (M,      counter);
+  mm.addElseTransition(E,E,counter);
+  mm.addEOFTransition (E);
+
+  auto const str = "++--+-+-++-a++-+";
+
+  WHEN("machine is interpreted"){
+    CountAllocations count;
+    mm.begin();
+    REQUIRE(mm.parse(str));
+    REQUIRE(mm.end());
+    REQUIRE(count.get() == 0);
+  }
+  WHEN("machine is compiled"){
+    mm.compile();
+    auto cursor = mm.createCursor();
+    CountAllocations count;
+    REQUIRE(mm.match(str));
+    cursor.begin();
+    REQUIRE(cursor.parse(str));
+    REQUIRE(cursor.end());
+    REQUIRE(count.get() == 0);
+  }
+}
+
+SCENARIO("deferred parsing into reserved action log does not allocate"){
+  size_t counter = 0;
+  MealyMachine mm;
+  auto S = mm.addState();
+  mm.addTransition   (S,"a",S,[&](MealyMachine*){counter++;});
+  mm.addTransition   (S,"b",S);
+  mm.addEOFTransition(S,[&](MealyMachine*){counter++;});
+  mm.compile();
+  mm.setDeferred(true);
+  mm.reserveActionLog(16);
+  {
+    CountAllocations count;
+    REQUIRE(mm.match("abababbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbba"));
+    REQUIRE(count.get() == 0);
+  }
+  REQUIRE(counter == 0);
+  mm.replay();
+  REQUIRE(counter == 5);
+}
+
+SCENARIO("parsing of split multi byte symbols does not allocate"){
+  MealyMachine mm(2);
+  mm.setQuiet(true);
+  auto start = mm.addState(std::make_shared<MapTransitionChooser<2>>());
+  mm.addTransition(start,"abcd",start);
+  mm.addEOFTransition(start);
+
+  CountAllocations count;
+  mm.begin();
+  REQUIRE(mm.parse("a"  ) == true );
+  REQUIRE(mm.parse("bcd") == true );
+  REQUIRE(mm.parse("ab" ) == true );
+  REQUIRE(mm.parse("xx" ) == false);
+  REQUIRE(mm.end()        == true );
+  REQUIRE(count.get() == 0);
+}
+
+SCENARIO("parsing with action programs does not allocate"){
+  using M = MealyMachine;
+  MealyMachine mm;
+  auto S = mm.addState();
+  auto P = mm.addState();
+  mm.addTransition    (S,"+",P,M::program({M::inc(0),M::mark(7)}));
+  mm.addTransition    (S," ",S);
+  mm.addEOFTransition (S);
+  mm.addTransition    (P,"+",S,M::program({M::inc(1)}));
+  mm.addElseTransition(P,S    ,M::program({M::inc(2),M::noMove()}));
+  mm.addEOFTransition (P      ,M::program({M::inc(2)}));
+  auto cursor = mm.createCursor();
+  {
+    CountAllocations count;
+    REQUIRE(mm.match("++ + +++"));
+    REQUIRE(cursor.match("++ + +++"));
+    REQUIRE(count.get() == 0);
+  }
+  REQUIRE(mm.getSlot(1) == 2);
+  REQUIRE(mm.getSlot(2) == 2);
+  REQUIRE(mm.getSlot(7) == 7);
+  mm.compile();
+  mm.clearSlots();
+  {
+    CountAllocations count;
+    REQUIRE(mm.match("++ + +++"));
+    REQUIRE(count.get() == 0);
+  }
+  REQUIRE(mm.getSlot(0) == 4);
+  MealyMachine large;
+  auto L = large.addState();
+  REQUIRE_THROWS_AS(large.addTransition(L,"a",L,M::program({M::inc(M::maxSlots)})),ex::Exception);
+}
+
+constexpr StaticMealyMachineBuilder<2>staticDigitsBuilder(){
+  StaticMealyMachineBuilder<2>b;
+  b.addTransition(0,'0','9',1,0);
+  b.addTransition(1,'0','9',1);
+  b.addEOFTransition(1);
+  return b;
+}
+
+static constexpr auto staticDigits = staticDigitsBuilder().compile<2>();
+
+struct DigitsCounter{
+  size_t numbers = 0;
+  void operator()(uint32_t,BasicMealyMachine<DigitsCounter>*){numbers++;}
+};
+
+SCENARIO("cursor of static tables does not allocate"){
+  CountAllocations count;
+  BasicMealyMachine<DigitsCounter>digits(staticDigits);
+  REQUIRE(digits.match("12345") == true);
+  REQUIRE(digits.getActions().numbers == 1);
+  REQUIRE(count.get() == 0);
+}
+
+SCENARIO("batch matching with kept cursors does not allocate"){
+  MealyMachine mm;
+  auto S = mm.addState();
+  auto D = mm.addState();
+  mm.addTransition   (S,"0123456789",D);
+  mm.addTransition   (D,"0123456789",D);
+  mm.addEOFTransition(D);
+  mm.setQuiet(true);
+  mm.compile();
+  std::vector<std::string>strings(2000,"12345");
+  for(size_t i=0;i<strings.size();i+=3)strings[i] = "12a";
+  std::vector<MealyMachine::Buffer>inputs;
+  for(auto const&string:strings)
+    inputs.push_back({(MealyMachine::BasicUnit const*)string.data(),string.size()});
+  std::vector<uint8_t>results(inputs.size());
+  ThreadPool pool(2);
+  std::vector<Cursor>cursors;
+  mm.matchMany(inputs.data(),inputs.size(),results.data(),pool,cursors);
+  REQUIRE(cursors.size() == pool.getNofWorkers());
+  std::fill(results.begin(),results.end(),2);
+  {
+    CountAllocations count;
+    mm.matchMany(inputs.data(),inputs.size(),results.data(),pool,cursors);
+    REQUIRE(count.get() == 0);
+  }
+  for(size_t i=0;i<results.size();++i)
+    REQUIRE(results[i] == (i%3 != 0));
+}
+
+SCENARIO("lexing with reserved lookahead does not allocate"){
+  enum Kind{NUMBER,FLOAT,DOT};
+  MealyMachine mm;
+  auto start  = mm.addState();
+  auto whole  = mm.addState();
+  auto dot    = mm.addState();
+  auto frac   = mm.addState();
+  auto single = mm.addState();
+  mm.addTransition(start,"0","9",whole );
+  mm.addTransition(whole,"0","9",whole );
+  mm.addTransition(whole,"."    ,dot   );
+  mm.addTransition(dot  ,"0","9",frac  );
+  mm.addTransition(frac ,"0","9",frac  );
+  mm.addTransition(start,"."    ,single);
+  mm.setAccepting(whole ,NUMBER);
+  mm.setAccepting(frac  ,FLOAT );
+  mm.setAccepting(single,DOT   );
+  mm.compile();
+  mm.reserveLookahead(16);
+  MealyMachine::TokenRecord tokens[8];
+  mm.setTokenBuffer(tokens,8);
+  CountAllocations count;
+  mm.begin();
+  //"12." is backtracked to "12" when "." is not followed by digit
+  REQUIRE(mm.lex("12") == true);
+  REQUIRE(mm.lex(".") == true);
+  REQUIRE(mm.lex(".5") == true);
+  REQUIRE(mm.endLex() == true);
+  REQUIRE(count.get() == 0);
+  REQUIRE(mm.getNofTokens() == 4);
+  REQUIRE(tokens[0].kind == NUMBER);
+  REQUIRE(tokens[1].kind == DOT   );
+  REQUIRE(tokens[2].kind == DOT   );
+  REQUIRE(tokens[3].kind == NUMBER);
+}
@@ -0,0 +1,21 @@
+#include<MealyMachine/MealyMachine.h>
+#include"testUtils.h"
+
+#include<fstream>
+#include<iostream>
+
+using namespace mealyMachine;
+using namespace testUtils;
+
+//writes direct coded scanner of + - ++ -- machine used by tests
+int main(int argc,char*argv[]){
+  if(argc != 2){
+    std::cerr << "usage: generateScanners <output header>" << std::endl;
+    return 1;
+  }
+  auto mm = buildOperatorMachine([](size_t,bool){return MealyMachine::Callback([](MealyMachine*){});});
+  mm.compile();
+  std::ofstream out(argv[1]);
+  mm.emitCpp(out,"OperatorScanner");
+  return out?0:1;
+}
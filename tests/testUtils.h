@@ -0,0 +1,64 @@
+#pragma once
+
+#include<MealyMachine/MealyMachine.h>
+
+#include<cstdint>
+#include<functional>
+#include<string>
+
+//helpers shared by tests and generateScanners
+namespace testUtils{
+  using mealyMachine::MealyMachine;
+
+  //linear congruential generator of randomized tests
+  class Random{
+    public:
+      Random(uint32_t seed):_seed(seed){}
+      uint32_t operator()(uint32_t n){
+        _seed = _seed*1103515245u+12345u;
+        return (_seed>>16)%n;
+      }
+      std::string string(std::string const&alphabet,size_t length){
+        std::string str;
+        while(str.size()<length)str += alphabet[(*this)(uint32_t(alphabet.size()))];
+        return str;
+      }
+    private:
+      uint32_t _seed;
+  };
+
+  //machine reads + - ++ -- separated by spaces
+  //action(counter,dontMove) creates callback of transition, the callbacks
+  //are actions 0..7 in the order of comments
+  //counter 0 counts +, 1 counts ++, 2 counts - and 3 counts --
+  using OperatorAction = std::function<MealyMachine::Callback(size_t counter,bool dontMove)>;
+  inline MealyMachine buildOperatorMachine(OperatorAction const&action){
+    MealyMachine mm;
+    auto S = mm.addState();
+    auto P = mm.addState();
+    auto M = mm.addState();
+    mm.addTransition    (S,"+",P);
+    mm.addTransition    (S,"-",M);
+    mm.addTransition    (S," ",S);
+    mm.addEOFTransition (S);
+    mm.addTransition    (P,"+",S,action(1,false));//action 0
+    mm.addTransition    (P,"-",M,action(0,false));//action 1
+    mm.addElseTransition(P,S    ,action(0,true ));//action 2
+    mm.addEOFTransition (P      ,action(0,false));//action 3
+    mm.addTransition    (M,"+",P,action(2,false));//action 4
+    mm.addElseTransition(M,S    ,action(2,true ));//action 5
+    mm.addEOFTransition (M      ,action(2,false));//action 6
+    mm.addTransition    (M,"-",S,action(3,false));//action 7
+    return mm;
+  }
+
+  //callbacks of buildOperatorMachine that count into counters
+  inline OperatorAction countInto(size_t*counters){
+    return [counters](size_t i,bool dontMove){
+      return MealyMachine::Callback([counters,i,dontMove](MealyMachine*m){
+        if(dontMove)m->dontMove();
+        counters[i]++;
+      });
+    };
+  }
+}
@@ -1,8 +1,36 @@
 #include<catch.hpp>
+#include<FloatScanner.h>
+#include<OperatorScanner.h>
 
 #include<MealyMachine/MealyMachine.h>
+#include<MealyMachine/AhoCorasickBuilder.h>
+#include<MealyMachine/BasicMealyMachine.h>
+#include<MealyMachine/ArrayTransitionChooser.h>
+#include<MealyMachine/HashTransitionChooser.h>
+#include<MealyMachine/IntervalTransitionChooser.h>
+#include<MealyMachine/MapTransitionChooser.h>
+#include<MealyMachine/Regex.h>
+#include<MealyMachine/StaticMealyMachine.h>
+#include<MealyMachine/ThreadPool.h>
+#include<MealyMachine/Exception.h>
+#include"testUtils.h"
+
+#include<algorithm>
+#include<atomic>
+#include<cstdio>
+#include<cstring>
+#include<fstream>
+#include<iterator>
+#include<map>
+#include<set>
+#include<regex>
+#include<sstream>
+#include<thread>
+#include<tuple>
+#include<type_traits>
 
 using namespace mealyMachine;
+using namespace testUtils;
 
 SCENARIO("Basic Mealy Machine tests"){
   //This machine reads + - ++ -- and count their appereances 
@@ -154,3 +182,1433 @@ SCENARIO("isFloat Mealy Machine test"){
   REQUIRE(mm.parse(".F")==false);
   REQUIRE(mm.end()==false);
 }
+
+SCENARIO("transition choosers test"){
+  auto build = [](MealyMachine&mm,std::shared_ptr<TransitionChooser>const&chooser){
+    mm.setQuiet(true);
+    auto start = mm.addState(chooser);
+    auto digit = mm.addState();
+    auto other = mm.addState();
+    mm.addTransition(start,"0","9",digit);
+    mm.addTransition(start,"a",other);
+    //last added transition wins
+    mm.addTransition(start,"5",other);
+    mm.addTransition(start,"\xff",digit);
+    mm.addEOFTransition(digit);
+  };
+  MealyMachine arrayMachine;
+  MealyMachine mapMachine;
+  build(arrayMachine,std::make_shared<ArrayTransitionChooser>());
+  build(mapMachine  ,std::make_shared<MapTransitionChooser<1>>());
+  for(auto const&str:{"0","9","5","a","b","\xff",""}){
+    REQUIRE(arrayMachine.match(str) == mapMachine.match(str));
+  }
+  REQUIRE(arrayMachine.match("0")    == true );
+  REQUIRE(arrayMachine.match("5")    == false);
+  REQUIRE(arrayMachine.match("\xff") == true );
+  REQUIRE(arrayMachine.str()         == mapMachine.str());
+}
+
+SCENARIO("compiled Mealy machine test"){
+  MealyMachine mm;
+  size_t plusCounter       = 0;
+  size_t plusPlusCounter   = 0;
+  size_t minusCounter      = 0;
+  size_t minusMinusCounter = 0;
+  size_t position          = 0;
+  size_t length            = 0;
+
+  auto S = mm.addState();
+  auto P = mm.addState();
+  auto M = mm.addState();
+  auto E = mm.addState();
+
+  mm.addTransition    (S,"+",P);
+  mm.addTransition    (S,"-",M);
+  mm.addElseTransition(S    ,E,[&](MealyMachine*){position = mm.getReadingPosition();length++;});
+  mm.addEOFTransition (S);
+  mm.addTransition    (P,"+",S,[&](MealyMachine*){plusPlusCounter++;});
+  mm.addTransition    (P,"-",M,[&](MealyMachine*){plusCounter++;});
+  mm.addElseTransition(P,    S,[&](MealyMachine*){mm.dontMove();plusCounter++;});
+  mm.addEOFTransition (P,      [&](MealyMachine*){plusCounter++;});
+  mm.addTransition    (M,"-",S,[&](MealyMachine*){minusMinusCounter++;});
+  mm.addTransition    (M,"+",P,[&](MealyMachine*){minusCounter++;});
+  mm.addElseTransition(M,    S,[&](MealyMachine*){mm.dontMove();minusCounter++;});
+  mm.addEOFTransition (M,      [&](MealyMachine*){minusCounter++;});
+  mm.addElseTransition(E,E,[&](MealyMachine*){length++;});
+  mm.addEOFTransition (E);
+
+  REQUIRE(mm.isCompiled() == false);
+  mm.compile();
+  REQUIRE(mm.isCompiled() == true);
+  REQUIRE_THROWS(mm.addState());
+  REQUIRE_THROWS(mm.addTransition(S,"a",S));
+  REQUIRE_THROWS(mm.compile());
+
+  mm.begin();
+  REQUIRE(mm.parse("++--+-+-") == true);
+  REQUIRE(mm.parse("++-a++-+") == true);
+  REQUIRE(mm.end()             == true);
+  REQUIRE(mm.getReadingPosition() == 16);
+  REQUIRE(plusCounter       == 2 );
+  REQUIRE(plusPlusCounter   == 2 );
+  REQUIRE(minusCounter      == 3 );
+  REQUIRE(minusMinusCounter == 1 );
+  REQUIRE(position          == 11);
+  REQUIRE(length            == 5 );
+
+  MealyMachine multiByte;
+  auto state = multiByte.addState(std::make_shared<MapTransitionChooser<1>>());
+  multiByte.addTransition(state,"a",state);
+  REQUIRE_NOTHROW(multiByte.compile());
+  MealyMachine wide(2);
+  wide.addState(std::make_shared<MapTransitionChooser<2>>());
+  REQUIRE_THROWS(wide.compile());
+
+  MealyMachine quiet;
+  quiet.setQuiet(true);
+  auto a = quiet.addState();
+  auto b = quiet.addState();
+  quiet.addTransition(a,"0","9",b);
+  quiet.addEOFTransition(b);
+  quiet.compile();
+  REQUIRE(quiet.match("7")  == true );
+  REQUIRE(quiet.match("x")  == false);
+  REQUIRE(quiet.match("77") == false);
+  REQUIRE(quiet.match("")   == false);
+  quiet.setQuiet(false);
+  REQUIRE_THROWS_AS(quiet.match("x"),ex::Exception);
+}
+
+SCENARIO("Mealy machine cursors test"){
+  MealyMachine mm;
+  mm.setQuiet(true);
+  auto start  = mm.addState();
+  auto number = mm.addState();
+  mm.addTransition(start ,"0","9",number);
+  mm.addTransition(number,"0","9",number);
+  std::atomic<size_t> wrongPositions(0);
+  mm.addEOFTransition(number,[&](MealyMachine*m){
+    //callbacks receive cursor that is parsing
+    if(m->getReadingPosition() != 1000)wrongPositions++;
+  });
+  mm.compile();
+
+  std::string const valid  (1000,'7');
+  std::string const invalid = valid + "x";
+  std::vector<size_t> matched(4,0);
+  std::vector<std::thread>threads;
+  for(size_t t=0;t<matched.size();++t)
+    threads.emplace_back([&,t]{
+      auto cursor = mm.createCursor();
+      for(size_t i=0;i<100;++i){
+        if(cursor.match(valid  .c_str()))matched[t]++;
+        if(cursor.match(invalid.c_str()))matched[t]++;
+      }
+    });
+  for(auto&t:threads)t.join();
+  for(auto const&m:matched)REQUIRE(m == 100);
+  REQUIRE(wrongPositions == 0);
+
+  auto cursor = mm.createCursor();
+  cursor.begin();
+  REQUIRE(cursor.parse("12") == true);
+  REQUIRE(cursor.getReadingPosition() == 2);
+  REQUIRE(mm.getReadingPosition()     == 0);
+  REQUIRE(cursor.isQuiet()            == true);
+
+  //cursor shares definition read-only and machine cannot be copied
+  static_assert(!std::is_copy_constructible<MealyMachine>::value,"");
+  static_assert(std::is_move_constructible<Cursor>::value,"");
+  MealyMachine growing;
+  auto g = growing.addState();
+  growing.addTransition(g,"a",g,[](MealyMachine*m){m->addState();});
+  growing.addEOFTransition(g);
+  auto growingCursor = growing.createCursor();
+  REQUIRE_THROWS_AS(growingCursor.match("a"),ex::Exception);
+  REQUIRE(growing.match("a") == true);
+}
+
+SCENARIO("interval transition chooser test"){
+  MealyMachine mm(2);
+  mm.setQuiet(true);
+  auto start = mm.addState(std::make_shared<IntervalTransitionChooser<2>>());
+  auto all   = mm.addState();
+  auto some  = mm.addState();
+  mm.addTransition(start,std::string("\x00\x00",2),std::string("\xff\xff",2),all);
+  //first byte is the least significant byte
+  mm.addTransition(start,std::string("\xf0\x01",2),std::string("\x0f\x02",2),some);
+  mm.addTransition(start,"ab",start);
+  mm.addEOFTransition(all);
+
+  //ranges are stored as one transition
+  std::stringstream ss(mm.str());
+  std::string line;
+  size_t startTransitions = 0;
+  std::getline(ss,line);
+  while(std::getline(ss,line) && line.find("state") != 0)startTransitions++;
+  REQUIRE(startTransitions == 3);
+
+  REQUIRE(mm.match((MealyMachine::BasicUnit const*)"\x00\x00",2) == true);
+  REQUIRE(mm.match("zz"                             ) == true );
+  REQUIRE(mm.match("\xef\x01"                       ) == true );
+  REQUIRE(mm.match("\xf0\x01"                       ) == false);
+  REQUIRE(mm.match("\xff\x01"                       ) == false);
+  REQUIRE(mm.match("\x01\x02"                       ) == false);
+  REQUIRE(mm.match("\x10\x02"                       ) == true );
+  REQUIRE(mm.match("abab\x10\x02"                   ) == true );
+  REQUIRE(mm.match("ab\x10\x02\x10\x02"             ) == false);
+
+  MealyMachine digits;
+  digits.setQuiet(true);
+  auto s = digits.addState(std::make_shared<IntervalTransitionChooser<1>>());
+  digits.addTransition(s,"0","9",s);
+  digits.addTransition(s,"5",s,[](MealyMachine*m){m->dontMove();});
+  digits.addTransition(s,"9","0",s);
+  digits.addEOFTransition(s);
+  REQUIRE(digits.match("0123498") == true );
+  REQUIRE(digits.match("01a"    ) == false);
+  digits.compile();
+  REQUIRE(digits.match("0123498") == true );
+  REQUIRE(digits.match("x"      ) == false);
+
+  //ranges mean the same for interval and enumerating choosers,
+  //later transitions override earlier ones
+  size_t hitInterval = 0;
+  size_t hitMap      = 0;
+  MealyMachine interval(2);
+  MealyMachine map     (2);
+  interval.setQuiet(true);
+  map     .setQuiet(true);
+  auto i = interval.addState(std::make_shared<IntervalTransitionChooser<2>>());
+  auto m = map     .addState(std::make_shared<MapTransitionChooser     <2>>());
+  auto symbol = [](uint32_t v){return std::string{char(v&0xff),char(v>>8)};};
+  auto addRange = [&](uint32_t lo,uint32_t hi,size_t id){
+    interval.addTransition(i,symbol(lo),symbol(hi),i,[&hitInterval,id](MealyMachine*){hitInterval = id;});
+    map     .addTransition(m,symbol(lo),symbol(hi),m,[&hitMap     ,id](MealyMachine*){hitMap      = id;});
+  };
+  addRange(0x00ff,0x0100,1);
+  Random random(9);
+  for(size_t id=2;id<40;++id){
+    auto lo = 0x00e0+random(0x140);
+    addRange(lo,lo+random(0x40),id);
+  }
+  addRange(0x0180,0x0170,40);
+  interval.addEOFTransition(i);
+  map     .addEOFTransition(m);
+  for(uint32_t v=0x00d0;v<0x0240;++v){
+    hitInterval = hitMap = 0;
+    auto const str = symbol(v);
+    auto const data = (MealyMachine::BasicUnit const*)str.data();
+    REQUIRE(interval.match(data,2) == map.match(data,2));
+    REQUIRE(hitInterval == hitMap);
+  }
+  REQUIRE(map.match((MealyMachine::BasicUnit const*)"\xff\x00",2) == true );
+  REQUIRE(map.match((MealyMachine::BasicUnit const*)"\x00\x00",2) == false);
+}
+
+SCENARIO("hash transition chooser test"){
+  auto build = [](MealyMachine&mm,std::shared_ptr<TransitionChooser>const&chooser){
+    mm.setQuiet(true);
+    auto opcode  = mm.addState(chooser);
+    auto operand = mm.addState(chooser);
+    //opcodes 4n+1 take operand, overriden opcode 0x0101 too
+    for(uint32_t i=0;i<1000;++i){
+      uint8_t symbol[4] = {uint8_t(i),uint8_t(i>>8),uint8_t(i*7),0};
+      mm.addTransition(opcode,symbol,i%4==1?operand:opcode);
+    }
+    mm.addTransition(opcode,std::string("\x01\x01\x07\x00",4),operand);
+    mm.addElseTransition(operand,opcode);
+    mm.addEOFTransition(opcode);
+  };
+  MealyMachine hashMachine(4);
+  MealyMachine mapMachine (4);
+  build(hashMachine,std::make_shared<HashTransitionChooser<4>>());
+  build(mapMachine ,std::make_shared<MapTransitionChooser <4>>());
+
+  std::vector<MealyMachine::BasicUnit>data;
+  Random random(7);
+  for(size_t i=0;i<4000;++i){
+    auto opcode = random(1100);
+    data.push_back(uint8_t(opcode));
+    data.push_back(uint8_t(opcode>>8));
+    data.push_back(uint8_t(opcode*7));
+    data.push_back(0);
+  }
+  for(size_t size=0;size<=data.size();size+=4)
+    REQUIRE(hashMachine.match(data.data(),size) == mapMachine.match(data.data(),size));
+
+  MealyMachine pairs(2);
+  pairs.setQuiet(true);
+  auto s = pairs.addState(std::make_shared<HashTransitionChooser<2>>());
+  pairs.addTransition(s,"aabbcc",s);
+  pairs.addEOFTransition(s);
+  REQUIRE(pairs.match("ccaabb") == true );
+  REQUIRE(pairs.match("ab"    ) == false);
+  REQUIRE(pairs.match((MealyMachine::BasicUnit const*)"\0\0",2) == false);
+  pairs.addTransition(s,std::string("\0\0",2),s);
+  REQUIRE(pairs.match((MealyMachine::BasicUnit const*)"\0\0",2) == true );
+}
+
+SCENARIO("compiled self-loops test"){
+  std::vector<std::pair<size_t,size_t>>log;
+  auto record = [&](MealyMachine*m){log.emplace_back(m->getReadingPosition(),m->getCurrentState());};
+  auto build = [&](MealyMachine&mm){
+    mm.setQuiet(true);
+    auto number     = mm.addState();
+    auto identifier = mm.addState();
+    auto other      = mm.addState();
+    mm.addTransition    (number    ,"0","9",number                 );
+    mm.addTransition    (number    ,"a","z",identifier,record      );
+    mm.addElseTransition(number    ,other                          );
+    //four ranges
+    mm.addTransition    (identifier,"a","z",identifier             );
+    mm.addTransition    (identifier,"A","Z",identifier             );
+    mm.addTransition    (identifier,"0","9",identifier             );
+    mm.addTransition    (identifier,"_"    ,identifier             );
+    mm.addTransition    (identifier,"."    ,number    ,record      );
+    mm.addElseTransition(identifier,other  ,record                 );
+    //too many ranges for SIMD
+    mm.addTransition    (other     ,"!#%&(*,.02468",other          );
+    mm.addElseTransition(other     ,number,[&](MealyMachine*m){m->dontMove();record(m);});
+    for(auto s:{number,identifier,other})mm.addEOFTransition(s,record);
+  };
+  MealyMachine interpreted;
+  MealyMachine compiled;
+  build(interpreted);
+  build(compiled   );
+  compiled.compile();
+
+  std::string const alphabet = "0123456789abcXYZ_.!#%&(*,+-";
+  Random random(1);
+  for(size_t i=0;i<300;++i){
+    std::string str;
+    auto length = random(200);
+    while(str.size()<length){
+      auto c = alphabet[random(alphabet.size())];
+      str += std::string(random(4)?1:random(70),c);
+    }
+    log.clear();
+    auto split = random(uint32_t(str.size()+1));
+    interpreted.begin();
+    auto r0 = interpreted.parse((MealyMachine::BasicUnit const*)str.data(),str.size()) && interpreted.end();
+    auto log0 = log;
+    log.clear();
+    compiled.begin();
+    auto r1 = compiled.parse((MealyMachine::BasicUnit const*)str.data(),split) &&
+              compiled.parse((MealyMachine::BasicUnit const*)str.data()+split,str.size()-split) &&
+              compiled.end();
+    REQUIRE(r0   == r1 );
+    REQUIRE(log0 == log);
+    REQUIRE(interpreted.getReadingPosition() == compiled.getReadingPosition());
+  }
+}
+
+SCENARIO("compiled symbol classes test"){
+  MealyMachine mm;
+  mm.setQuiet(true);
+  auto start   = mm.addState();
+  auto sign    = mm.addState();
+  auto number  = mm.addState();
+  auto postfix = mm.addState();
+  mm.addTransition   (start ,"+-"   ,sign   );
+  mm.addTransition   (start ,"0","9",number );
+  mm.addTransition   (sign  ,"0","9",number );
+  mm.addTransition   (number,"0","9",number );
+  mm.addTransition   (number,"fF"   ,postfix);
+  mm.addEOFTransition(number                );
+  mm.addEOFTransition(postfix               );
+  REQUIRE(mm.getNofSymbolClasses() == 0);
+  mm.compile();
+  //digits, signs, postfix and everything else
+  REQUIRE(mm.getNofSymbolClasses() == 4);
+  REQUIRE(mm.match("-12f") == true );
+  REQUIRE(mm.match("+1F" ) == true );
+  REQUIRE(mm.match("1-"  ) == false);
+  REQUIRE(mm.match("f"   ) == false);
+  REQUIRE(mm.match("1ff" ) == false);
+}
+
+SCENARIO("Mealy machine minimization test"){
+  auto build = [](MealyMachine&mm,MealyMachine::Callback const&cb){
+    mm.setQuiet(true);
+    auto start  = mm.addState();
+    auto a      = mm.addState();
+    auto b      = mm.addState();
+    auto end    = mm.addState();
+    auto unused = mm.addState();
+    //a and b are equivalent
+    mm.addTransition   (start ,"a"     ,a     );
+    mm.addTransition   (start ,"b"     ,b     );
+    mm.addTransition   (a     ,"0","9" ,a     );
+    mm.addTransition   (b     ,"0","9" ,b     );
+    mm.addTransition   (a     ,";"     ,end   ,cb);
+    mm.addTransition   (b     ,";"     ,end   ,cb);
+    mm.addTransition   (unused,"x"     ,start );
+    mm.addEOFTransition(end                   );
+  };
+  size_t counter = 0;
+  auto cb = [&](MealyMachine*){counter++;};
+  MealyMachine mm;
+  build(mm,cb);
+  mm.compile();
+  MealyMachine minimized;
+  build(minimized,cb);
+  auto const report = minimized.minimize();
+  REQUIRE(report.statesBefore == 5);
+  //callbacks are different, a and b cannot be merged
+  REQUIRE(report.statesAfter  == 4);
+  REQUIRE(minimized.getNofSymbolClasses() <= mm.getNofSymbolClasses());
+
+  MealyMachine shared;
+  shared.setQuiet(true);
+  auto start = shared.addState();
+  auto a     = shared.addState();
+  auto b     = shared.addState();
+  auto end   = shared.addState();
+  shared.addTransition   (start,"a"   ,a       );
+  shared.addTransition   (start,"b"   ,b       );
+  shared.addTransition   (a    ,"0","9",a      );
+  shared.addTransition   (b    ,"0","9",b      );
+  shared.addTransition   (a    ,";"   ,end     );
+  shared.addTransition   (b    ,";"   ,end     );
+  shared.addEOFTransition(end                  );
+  REQUIRE(shared.minimize().statesAfter == 3);
+  REQUIRE(shared.match("b12;") == true );
+  REQUIRE(shared.match("ab;" ) == false);
+
+  std::string const alphabet = "ab0123456789;x";
+  Random random(7);
+  for(size_t i=0;i<1000;++i){
+    auto str = random.string(alphabet,random(8));
+    counter = 0;
+    auto expected        = mm.match(str.c_str());
+    auto expectedCounter = counter;
+    counter = 0;
+    REQUIRE(minimized.match(str.c_str()) == expected       );
+    REQUIRE(counter                      == expectedCounter);
+  }
+}
+
+SCENARIO("parallel parsing test"){
+  //csv-like rows of numbers and quoted strings
+  MealyMachine mm;
+  auto fieldStart = mm.addState();
+  auto number     = mm.addState();
+  auto quoted     = mm.addState();
+  mm.addTransition    (fieldStart,"0","9" ,number    );
+  mm.addTransition    (fieldStart,"\""    ,quoted    );
+  mm.addTransition    (number    ,"0","9" ,number    );
+  mm.addTransition    (number    ,",\n"   ,fieldStart);
+  mm.addTransition    (quoted    ,"\""    ,number    );
+  mm.addElseTransition(quoted    ,quoted             );
+  mm.addEOFTransition (number                        );
+  REQUIRE_THROWS(mm.parseParallel((MealyMachine::BasicUnit const*)"1",1));
+  mm.compile();
+
+  Random random(3);
+  std::string str;
+  while(str.size() < (1<<20)){
+    if(random(2))str += std::to_string(random(100000));
+    else str += "\"" + std::string(random(100),'a'+random(26)) + ",\"";
+    str += random(8)?",":"\n";
+  }
+  str += "1";
+  auto const data = (MealyMachine::BasicUnit const*)str.data();
+  for(size_t threads:{2,3,7}){
+    mm.begin();
+    REQUIRE(mm.parseParallel(data,str.size(),threads) == true);
+    REQUIRE(mm.getReadingPosition() == str.size());
+    REQUIRE(mm.end() == true);
+  }
+
+  //error in the middle of the buffer is reported at the same position
+  auto broken = str;
+  broken[broken.find('\n',broken.size()/2+12345)+1] = 'x';
+  auto const brokenData = (MealyMachine::BasicUnit const*)broken.data();
+  mm.setQuiet(true);
+  mm.begin();
+  auto const expected = mm.parse(brokenData,broken.size());
+  REQUIRE(expected == false);
+  auto const position = mm.getReadingPosition();
+  auto const state    = mm.getCurrentState();
+  for(size_t threads:{2,5}){
+    mm.begin();
+    REQUIRE(mm.parseParallel(brokenData,broken.size(),threads) == expected);
+    REQUIRE(mm.getReadingPosition() == position);
+    REQUIRE(mm.getCurrentState()    == state   );
+  }
+  mm.setQuiet(false);
+  mm.begin();
+  REQUIRE_THROWS_AS(mm.parseParallel(brokenData,broken.size(),4),ex::Exception);
+
+  MealyMachine withCallback;
+  auto s = withCallback.addState();
+  withCallback.addTransition(s,"a",s,[](MealyMachine*){});
+  withCallback.compile();
+  REQUIRE_THROWS(withCallback.parseParallel((MealyMachine::BasicUnit const*)"a",1));
+}
+
+SCENARIO("thread pool test"){
+  for(size_t workers:{1,2,5}){
+    ThreadPool pool(workers);
+    REQUIRE(pool.getNofWorkers() == workers);
+    std::vector<std::atomic<size_t>>visits(10007);
+    for(auto&v:visits)v = 0;
+    std::atomic<size_t>wrongWorker(0);
+    pool.parallelFor(visits.size(),13,[&](size_t worker,size_t begin,size_t end){
+      if(worker >= workers || end-begin > 13)wrongWorker++;
+      for(auto i=begin;i<end;++i)visits[i]++;
+    });
+    REQUIRE(wrongWorker == 0);
+    REQUIRE(std::all_of(visits.begin(),visits.end(),[](std::atomic<size_t>const&v){return v == 1;}));
+    REQUIRE_THROWS_AS(pool.parallelFor(100,1,[](size_t,size_t begin,size_t){if(begin == 42)throw ex::Exception("task");}),ex::Exception);
+    //pool is usable after exception
+    std::atomic<size_t>counter(0);
+    pool.parallelFor(100,7,[&](size_t,size_t begin,size_t end){counter += end-begin;});
+    REQUIRE(counter == 100);
+  }
+}
+
+SCENARIO("match many test"){
+  MealyMachine mm;
+  mm.setQuiet(true);
+  auto start  = mm.addState();
+  auto number = mm.addState();
+  std::atomic<size_t>signs(0);
+  mm.addTransition   (start ,"+-"    ,number,[&](MealyMachine*){signs++;});
+  mm.addTransition   (start ,"0","9" ,number);
+  mm.addTransition   (number,"0","9" ,number);
+  mm.addEOFTransition(number               );
+  mm.compile();
+
+  Random random(5);
+  std::string const alphabet = "+-0123456789x";
+  std::vector<std::string>inputs(5000);
+  for(auto&input:inputs){
+    auto length = random(10);
+    while(input.size()<length)input += alphabet[random(alphabet.size())];
+  }
+  std::vector<uint8_t>expected;
+  for(auto const&input:inputs)expected.push_back(mm.match(input.c_str()));
+  auto const expectedSigns = signs.load();
+  for(size_t workers:{1,4}){
+    ThreadPool pool(workers);
+    std::vector<uint8_t>results;
+    signs = 0;
+    mm.matchMany(inputs,results,pool);
+    REQUIRE(results == expected     );
+    REQUIRE(signs   == expectedSigns);
+  }
+  MealyMachine loud;
+  auto s = loud.addState();
+  loud.addTransition(s,"a",s);
+  ThreadPool pool(3);
+  std::vector<uint8_t>results;
+  REQUIRE_THROWS_AS(loud.matchMany(std::vector<std::string>(1000,"ab"),results,pool),ex::Exception);
+}
+
+SCENARIO("interleaved match test"){
+  std::vector<std::string>log;
+  auto build = [&](MealyMachine&mm){
+    auto start  = mm.addState();
+    auto number = mm.addState();
+    auto suffix = mm.addState();
+    mm.addTransition   (start ,"+-"    ,number,[&](MealyMachine*m){log.push_back("sign"+std::to_string(m->getReadingPosition()));});
+    mm.addTransition   (start ,"0","9" ,number);
+    mm.addTransition   (number,"0","9" ,number);
+    mm.addTransition   (number,"u"     ,suffix);
+    mm.addEOFTransition(number               );
+    mm.addEOFTransition(suffix,[&](MealyMachine*){log.push_back("unsigned");});
+  };
+  Random random(11);
+  std::string const alphabet = "+-0123456789u";
+  std::vector<std::string>strings(1000);
+  for(auto&str:strings){
+    auto length = random(random(4)?8:40);
+    while(str.size()<length)str += alphabet[random(alphabet.size())];
+  }
+  std::vector<MealyMachine::Buffer>inputs;
+  for(auto const&str:strings)inputs.push_back({(MealyMachine::BasicUnit const*)str.data(),str.size()});
+
+  for(bool compile:{false,true}){
+    MealyMachine mm;
+    mm.setQuiet(true);
+    build(mm);
+    if(compile)mm.compile();
+    log.clear();
+    std::vector<uint8_t>expected;
+    for(auto const&input:inputs)expected.push_back(mm.match(input.data,input.size));
+    auto const expectedLog = log;
+    log.clear();
+    std::vector<uint8_t>results(inputs.size());
+    mm.matchInterleaved(inputs.data(),inputs.size(),results.data());
+    REQUIRE(results == expected   );
+    REQUIRE(log     == expectedLog);
+    //cursor is left as after match of the last input
+    for(size_t count=1;count<=40;++count){
+      auto const&input = inputs[count-1];
+      mm.match(input.data,input.size);
+      auto const state    = mm.getCurrentState   ();
+      auto const position = mm.getReadingPosition();
+      mm.begin();
+      mm.matchInterleaved(inputs.data(),count,results.data());
+      REQUIRE(mm.getCurrentState   () == state   );
+      REQUIRE(mm.getReadingPosition() == position);
+    }
+  }
+
+  MealyMachine loud;
+  build(loud);
+  loud.compile();
+  std::vector<uint8_t>results(inputs.size());
+  REQUIRE_THROWS_AS(loud.matchInterleaved(inputs.data(),inputs.size(),results.data()),ex::Exception);
+}
+
+SCENARIO("deferred callbacks test"){
+  std::vector<std::string>log;
+  auto record = [&](std::string const&name){
+    return [&,name](MealyMachine*m){log.push_back(name+std::to_string(m->getCurrentState())+":"+std::to_string(m->getReadingPosition()));};
+  };
+  auto build = [&](MealyMachine&mm){
+    auto start  = mm.addState();
+    auto number = mm.addState();
+    mm.addTransition   (start ,"0","9",number,record("number"));
+    mm.addTransition   (start ," "    ,start                  );
+    mm.addTransition   (number,"0","9",number                 );
+    mm.addTransition   (number," "    ,start ,record("space" ));
+    mm.addEOFTransition(start         ,record("eof"   ));
+    mm.addEOFTransition(number        ,record("eof"   ));
+  };
+  std::string const str = "12 345   6                    78 9";
+  for(bool compile:{false,true}){
+    MealyMachine mm;
+    build(mm);
+    if(compile)mm.compile();
+    log.clear();
+    REQUIRE(mm.match(str.c_str()) == true);
+    auto const expected = log;
+    log.clear();
+    mm.setDeferred(true);
+    REQUIRE(mm.isDeferred() == true);
+    mm.reserveActionLog(64);
+    mm.begin();
+    REQUIRE(mm.parse(str.substr(0,20).c_str()) == true);
+    REQUIRE(mm.parse(str.substr(20  ).c_str()) == true);
+    REQUIRE(mm.end() == true);
+    REQUIRE(log.empty() == true);
+    REQUIRE(mm.getActionLog().size() == expected.size());
+    mm.replay();
+    REQUIRE(log == expected);
+    REQUIRE(mm.getActionLog().empty() == true);
+    REQUIRE(mm.getReadingPosition() == str.size());
+  }
+
+  MealyMachine mm;
+  auto start = mm.addState();
+  mm.addTransition(start,"a",start,[](MealyMachine*m){m->dontMove();});
+  mm.compile();
+  mm.setDeferred(true);
+  REQUIRE(mm.match("aa") == false);
+  REQUIRE_THROWS_AS(mm.replay(),ex::Exception);
+  REQUIRE(mm.getActionLog().size() == 1);
+}
+
+SCENARIO("token emission test"){
+  enum Kind{NUMBER,WORD,PLUS};
+  auto build = [](MealyMachine&mm){
+    auto start  = mm.addState();
+    auto number = mm.addState();
+    auto word   = mm.addState();
+    auto const E  = MealyMachine::TOKEN_END;
+    auto const B  = MealyMachine::TOKEN_BEGIN;
+    auto const EA = MealyMachine::TOKEN_END_AFTER;
+    mm.addTransition   (start ,"0","9",number,MealyMachine::token(B            ));
+    mm.addTransition   (start ,"a","z",word  ,MealyMachine::token(B            ));
+    mm.addTransition   (start ,"+"    ,start ,MealyMachine::token(B|EA  ,PLUS  ));
+    mm.addTransition   (start ," "    ,start                                    );
+    mm.addTransition   (number,"0","9",number                                   );
+    mm.addTransition   (number," "    ,start ,MealyMachine::token(E     ,NUMBER));
+    mm.addTransition   (number,"+"    ,start ,MealyMachine::token(E|B|EA,NUMBER,PLUS));
+    mm.addTransition   (word  ,"a","z",word                                     );
+    mm.addTransition   (word  ," "    ,start ,MealyMachine::token(E     ,WORD  ));
+    mm.addEOFTransition(start                                                   );
+    mm.addEOFTransition(number        ,MealyMachine::token(E     ,NUMBER));
+    mm.addEOFTransition(word          ,MealyMachine::token(E     ,WORD  ));
+  };
+  std::string const str = "12+ abc +  7 x";
+  std::vector<MealyMachine::TokenRecord>expected = {
+    {0 ,2 ,NUMBER},
+    {2 ,3 ,PLUS  },
+    {4 ,7 ,WORD  },
+    {8 ,9 ,PLUS  },
+    {11,12,NUMBER},
+    {13,14,WORD  },
+  };
+  for(bool compile:{false,true})for(bool deferred:{false,true}){
+    MealyMachine mm;
+    build(mm);
+    if(compile)mm.compile();
+    mm.setDeferred(deferred);
+    std::vector<MealyMachine::TokenRecord>tokens(16);
+    mm.setTokenBuffer(tokens.data(),tokens.size());
+    mm.begin();
+    //tokens can span parse calls
+    REQUIRE(mm.parse(str.substr(0,5).c_str()) == true);
+    REQUIRE(mm.parse(str.substr(5  ).c_str()) == true);
+    REQUIRE(mm.end() == true);
+    REQUIRE(mm.getActionLog().empty() == true);
+    REQUIRE(mm.getNofTokens() == expected.size());
+    for(size_t i=0;i<expected.size();++i){
+      REQUIRE(tokens[i].begin == expected[i].begin);
+      REQUIRE(tokens[i].kind  == expected[i].kind );
+      REQUIRE(tokens[i].end   == expected[i].end  );
+    }
+    REQUIRE(str.substr(tokens[2].begin,tokens[2].end-tokens[2].begin) == "abc");
+    mm.clearTokens();
+    REQUIRE(mm.getNofTokens() == 0);
+  }
+
+  //both kinds are saved
+  MealyMachine saved;
+  build(saved);
+  saved.compile();
+  std::string const path = "mealyMachineTokenTest.bin";
+  saved.save(path);
+  auto loaded = MealyMachine::load(path);
+  std::remove(path.c_str());
+  std::vector<MealyMachine::TokenRecord>loadedTokens(16);
+  loaded.setTokenBuffer(loadedTokens.data(),loadedTokens.size());
+  REQUIRE(loaded.match(str.c_str()) == true);
+  REQUIRE(loaded.getNofTokens() == expected.size());
+  REQUIRE(loadedTokens[0].kind == NUMBER);
+  REQUIRE(loadedTokens[1].kind == PLUS  );
+
+  MealyMachine small;
+  build(small);
+  MealyMachine::TokenRecord one[1];
+  small.setTokenBuffer(one,1);
+  REQUIRE_THROWS_AS(small.match("1 2"),ex::Exception);
+
+  size_t counter = 0;
+  MealyMachine withCallback;
+  auto s = withCallback.addState();
+  withCallback.addTransition(s,"a",s,MealyMachine::token(MealyMachine::TOKEN_BEGIN|MealyMachine::TOKEN_END_AFTER,1,[&](MealyMachine*){counter++;}));
+  withCallback.setTokenBuffer(one,1);
+  REQUIRE(withCallback.parse("a") == true);
+  REQUIRE(counter == 1);
+  REQUIRE(one[0].end == 1);
+}
+
+SCENARIO("longest match lexer test"){
+  enum Kind{NUMBER,FLOAT,DOT,SPACE};
+  MealyMachine mm;
+  auto start  = mm.addState();
+  auto whole  = mm.addState();
+  auto dot    = mm.addState();
+  auto frac   = mm.addState();
+  auto single = mm.addState();
+  auto space  = mm.addState();
+  mm.addTransition(start,"0","9",whole );
+  mm.addTransition(whole,"0","9",whole );
+  mm.addTransition(whole,"."    ,dot   );
+  mm.addTransition(dot  ,"0","9",frac  );
+  mm.addTransition(frac ,"0","9",frac  );
+  mm.addTransition(start,"."    ,single);
+  mm.addTransition(start," "    ,space );
+  mm.addTransition(space," "    ,space );
+  mm.setAccepting(whole ,NUMBER);
+  mm.setAccepting(frac  ,FLOAT );
+  mm.setAccepting(single,DOT   );
+  mm.setAccepting(space ,SPACE );
+  REQUIRE_THROWS(mm.lex("1"));
+  mm.compile();
+
+  std::string const str = "12.5 7.  3.14 8.";
+  std::vector<std::string>expected = {"12.5","F"," ","S","7","N",".","D","  ","S","3.14","F"," ","S","8","N",".","D"};
+  auto tokensToStrings = [&](std::vector<MealyMachine::TokenRecord>const&tokens,size_t n){
+    std::vector<std::string>result;
+    for(size_t i=0;i<n;++i){
+      result.push_back(str.substr(tokens[i].begin,tokens[i].end-tokens[i].begin));
+      result.push_back(std::string(1,"NFDS"[tokens[i].kind]));
+    }
+    return result;
+  };
+  std::vector<MealyMachine::TokenRecord>tokens(32);
+  //all splits into three chunks
+  for(size_t a=0;a<=str.size();++a)for(size_t b=a;b<=str.size();++b){
+    mm.setTokenBuffer(tokens.data(),tokens.size());
+    mm.begin();
+    REQUIRE(mm.lex((MealyMachine::BasicUnit const*)str.data()  ,a           ) == true);
+    REQUIRE(mm.lex((MealyMachine::BasicUnit const*)str.data()+a,b-a         ) == true);
+    REQUIRE(mm.lex((MealyMachine::BasicUnit const*)str.data()+b,str.size()-b) == true);
+    REQUIRE(mm.endLex() == true);
+    REQUIRE(tokensToStrings(tokens,mm.getNofTokens()) == expected);
+  }
+
+  mm.setQuiet(true);
+  mm.setTokenBuffer(tokens.data(),tokens.size());
+  mm.begin();
+  REQUIRE(mm.lex("1 x") == false);
+  REQUIRE(mm.getReadingPosition() == 2);
+  //"." after "1" has to be kept for backtracking
+  mm.begin();
+  mm.setMaxLookahead(0);
+  REQUIRE(mm.lex("12") == true );
+  REQUIRE(mm.lex("1.") == false);
+  mm.setQuiet(false);
+  mm.begin();
+  REQUIRE_THROWS_AS(mm.lex("1."),ex::ParsingError);
+  mm.setMaxLookahead(1);
+  mm.begin();
+  REQUIRE(mm.lex("1.") == true);
+
+  //lexer states survive minimization
+  MealyMachine twice;
+  auto s0 = twice.addState();
+  auto a  = twice.addState();
+  auto b  = twice.addState();
+  twice.addTransition(s0,"a",a);
+  twice.addTransition(s0,"b",b);
+  twice.setAccepting(a,0);
+  twice.setAccepting(b,1);
+  REQUIRE(twice.minimize().statesAfter == 3);
+  twice.setTokenBuffer(tokens.data(),tokens.size());
+  twice.begin();
+  REQUIRE(twice.lex("ab") == true);
+  REQUIRE(twice.endLex() == true);
+  REQUIRE(twice.getNofTokens() == 2);
+  REQUIRE(tokens[1].kind == 1);
+}
+
+SCENARIO("regex compiler test"){
+  std::vector<std::string>const patterns = {
+    "[+-]?(\\d+\\.?\\d*|\\.\\d+)([eE][+-]?\\d+)?[fF]?",
+    "a(b|c)*d",
+    "(ab|a)(bc|c)?",
+    "x{2,3}y{2}z{0,}",
+    "[^a-c]+\\x41?",
+    "(?:a|)+b?",
+    "\\w+\\s\\W",
+    "a.b",
+    "[\\b]a",
+    "",
+  };
+  std::string const alphabet = std::string("0123456789.+-eEfFabcdxyzA _\r\n\b");
+  Random random(13);
+  for(auto const&pattern:patterns){
+    auto mm = compileRegex(pattern);
+    REQUIRE(mm.isCompiled() == true);
+    mm.setQuiet(true);
+    std::regex const re(pattern);
+    for(size_t i=0;i<2000;++i){
+      auto str = random.string(alphabet,random(10));
+      REQUIRE(mm.match(str.c_str()) == std::regex_match(str,re));
+    }
+  }
+
+  std::map<size_t,size_t>begins;
+  std::map<size_t,size_t>ends;
+  auto mm = compileRegex("(a+)(b+)",[&](MealyMachine*,size_t group,GroupBoundary boundary,size_t position){
+    if(boundary == GROUP_BEGIN)begins[group] = position;
+    else ends[group] = position;
+  });
+  REQUIRE(mm.match("aabbb") == true);
+  REQUIRE(begins[1] == 0);
+  REQUIRE(ends  [1] == 2);
+  REQUIRE(begins[2] == 2);
+  REQUIRE(ends  [2] == 5);
+
+  //alternatives that do not accept the next symbol report no boundaries
+  std::vector<std::tuple<size_t,GroupBoundary,size_t>>events;
+  auto alternation = compileRegex("(a)|(b)|(bc)",[&](MealyMachine*,size_t group,GroupBoundary boundary,size_t position){
+    events.emplace_back(group,boundary,position);
+  });
+  REQUIRE(alternation.match("b") == true);
+  REQUIRE(events == decltype(events){{2,GROUP_BEGIN,0},{3,GROUP_BEGIN,0},{2,GROUP_END,1}});
+  events.clear();
+  REQUIRE(alternation.match("a") == true);
+  REQUIRE(events == decltype(events){{1,GROUP_BEGIN,0},{1,GROUP_END,1}});
+  //group that fails later still reports its beginning
+  events.clear();
+  REQUIRE(alternation.match("bc") == true);
+  REQUIRE(events == decltype(events){{2,GROUP_BEGIN,0},{3,GROUP_BEGIN,0},{3,GROUP_END,2}});
+
+  //several patterns form a lexer, earlier pattern wins
+  auto lexer = compileRegex(std::vector<std::string>{"if","[a-z]+","[0-9]+"," +"});
+  std::vector<MealyMachine::TokenRecord>tokens(16);
+  lexer.setTokenBuffer(tokens.data(),tokens.size());
+  lexer.begin();
+  REQUIRE(lexer.lex("if iff 42") == true);
+  REQUIRE(lexer.endLex() == true);
+  REQUIRE(lexer.getNofTokens() == 5);
+  REQUIRE(tokens[0].kind == 0);
+  REQUIRE(tokens[2].kind == 1);
+  REQUIRE(tokens[4].kind == 2);
+
+  REQUIRE_THROWS_AS(compileRegex("(a"  ),ex::Exception);
+  REQUIRE_THROWS_AS(compileRegex("a)"  ),ex::Exception);
+  REQUIRE_THROWS_AS(compileRegex("*"   ),ex::Exception);
+  REQUIRE_THROWS_AS(compileRegex("[b-a]"),ex::Exception);
+  REQUIRE_THROWS_AS(compileRegex("a{3,2}"),ex::Exception);
+  REQUIRE_THROWS_AS(compileRegex("((a{1000}){1000}){1000}"),ex::Exception);
+  REQUIRE_THROWS_AS(compileRegex("^ab$" ),ex::Exception);
+  REQUIRE_THROWS_AS(compileRegex("ab$"  ),ex::Exception);
+  REQUIRE_THROWS_AS(compileRegex("a\\bb" ),ex::Exception);
+  REQUIRE_THROWS_AS(compileRegex("a\\Bb" ),ex::Exception);
+  REQUIRE_THROWS_AS(compileRegex("(a)\\1"),ex::Exception);
+  REQUIRE_THROWS_AS(compileRegex("\\u0041"),ex::Exception);
+  auto dot = compileRegex("a.b");
+  dot.setQuiet(true);
+  REQUIRE(dot.match("a\rb") == false);
+  REQUIRE(dot.match("a\rb") == std::regex_match("a\rb",std::regex("a.b")));
+}
+
+SCENARIO("Aho-Corasick builder test"){
+  Random random(7);
+  AhoCorasickBuilder builder;
+  std::vector<std::string>patterns;
+  for(size_t i=0;i<40;++i){
+    patterns.push_back(random.string("abc",1+random(4)));
+    REQUIRE(builder.addPattern(patterns.back()) == i);
+  }
+  REQUIRE(builder.getNofPatterns() == patterns.size());
+  REQUIRE_THROWS_AS(builder.addPattern(""),ex::Exception);
+
+  std::set<std::pair<size_t,size_t>>found;
+  auto mm = builder.build([&](MealyMachine*,size_t pattern,size_t end){
+    REQUIRE(found.insert(std::make_pair(pattern,end)).second == true);
+  });
+  REQUIRE(mm.isCompiled() == true);
+  //one action per set of occurrences, bytes that do not occur in patterns
+  //share one class
+  REQUIRE(mm.getNofActions() <= patterns.size());
+  REQUIRE(mm.getNofSymbolClasses() == 4);
+  std::vector<MealyMachine::TokenRecord>tokens(4096);
+  auto tokenizer = builder.build();
+  tokenizer.setTokenBuffer(tokens.data(),tokens.size());
+  //actions do not depend on numbering of states
+  auto minimized = builder.build([&](MealyMachine*,size_t pattern,size_t end){
+    REQUIRE(found.insert(std::make_pair(pattern,end)).second == true);
+  });
+  auto const report = minimized.minimize();
+  REQUIRE(report.statesAfter <= report.statesBefore);
+  for(size_t i=0;i<50;++i){
+    auto const text = random.string("abcd",random(64));
+    std::set<std::pair<size_t,size_t>>expected;
+    for(size_t p=0;p<patterns.size();++p)
+      for(auto pos = text.find(patterns[p]);pos != std::string::npos;pos = text.find(patterns[p],pos+1))
+        expected.insert(std::make_pair(p,pos+patterns[p].size()));
+    found.clear();
+    REQUIRE(mm.match(text.c_str()) == true);
+    REQUIRE(found == expected);
+    found.clear();
+    REQUIRE(minimized.match(text.c_str()) == true);
+    REQUIRE(found == expected);
+
+    tokenizer.clearTokens();
+    REQUIRE(tokenizer.match(text.c_str()) == true);
+    REQUIRE(tokenizer.getNofTokens() == expected.size());
+    std::set<std::pair<size_t,size_t>>emitted;
+    for(size_t t=0;t<tokenizer.getNofTokens();++t){
+      REQUIRE(tokens[t].end-tokens[t].begin == patterns[tokens[t].kind].size());
+      emitted.insert(std::make_pair(size_t(tokens[t].kind),size_t(tokens[t].end)));
+    }
+    REQUIRE(emitted == expected);
+  }
+}
+
+SCENARIO("UTF-8 code point range test"){
+  auto encode = [](uint32_t cp){
+    std::string str;
+    if(cp<0x80)str += char(cp);
+    else if(cp<0x800){str += char(0xc0|(cp>>6));str += char(0x80|(cp&0x3f));}
+    else if(cp<0x10000){str += char(0xe0|(cp>>12));str += char(0x80|((cp>>6)&0x3f));str += char(0x80|(cp&0x3f));}
+    else{str += char(0xf0|(cp>>18));str += char(0x80|((cp>>12)&0x3f));str += char(0x80|((cp>>6)&0x3f));str += char(0x80|(cp&0x3f));}
+    return str;
+  };
+  std::vector<MealyMachine::CodepointRange>const ranges = {
+    {0x41,0x5a},{0x3b1,0x3c9},{0x7ff,0x801},{0x3040,0x309f},{0xd000,0xe000},{0xfff0,0x10010},{0x10fff0,0x10ffff},
+  };
+  auto inRanges = [&](uint32_t cp){
+    if(cp>=0xd800&&cp<=0xdfff)return false;
+    for(auto const&r:ranges)if(cp>=r.lo&&cp<=r.hi)return true;
+    return false;
+  };
+  size_t codepoints = 0;
+  MealyMachine mm;
+  auto start = mm.addState();
+  auto end   = mm.addState();
+  mm.addCodepointRanges(start,ranges,end,[&](MealyMachine*){codepoints++;});
+  mm.addEOFTransition(end);
+  mm.setQuiet(true);
+  for(uint32_t cp=0;cp<=0x10ffff;++cp){
+    if(cp>=0xd800&&cp<=0xdfff)continue;
+    codepoints = 0;
+    auto const expected = inRanges(cp);
+    REQUIRE(mm.match(encode(cp).c_str()) == expected);
+    REQUIRE(codepoints == size_t(expected));
+  }
+  //surrogates and overlong encodings
+  REQUIRE(mm.match("\xed\xa0\x80") == false);
+  REQUIRE(mm.match("\xc1\x81"    ) == false);
+  REQUIRE(mm.match("\xe0\x81\x81") == false);
+  REQUIRE(mm.match("\xce"        ) == false);
+
+  //loop over all code points stays on byte table and is minimal
+  MealyMachine text;
+  auto s = text.addState();
+  text.addCodepointRange(s,0x1,0x10ffff,s,[&](MealyMachine*){codepoints++;});
+  text.addEOFTransition(s);
+  auto const report = text.minimize();
+  REQUIRE(report.statesBefore == report.statesAfter);
+  REQUIRE(text.isCompiled() == true);
+  codepoints = 0;
+  REQUIRE(text.match((encode(0x3b1)+"x"+encode(0x10348)+encode(0xffff)).c_str()) == true);
+  REQUIRE(codepoints == 4);
+
+  REQUIRE_THROWS_AS(mm.addCodepointRange(start,5,4,end),ex::Exception);
+  REQUIRE_THROWS_AS(mm.addCodepointRange(start,0,0x110000,end),ex::Exception);
+}
+
+SCENARIO("save and load test"){
+  std::string const path = "mealyMachineSaveLoadTest.bin";
+  size_t digits = 0;
+  size_t words  = 0;
+  MealyMachine mm;
+  auto start = mm.addState();
+  auto digit = mm.addState();
+  mm.addTransition(start,"0","9",digit,[&](MealyMachine*){digits++;});
+  mm.addTransition(digit,"0","9",digit);
+  mm.addTransition(digit," "    ,start);
+  mm.addTransition(start," "    ,start);
+  mm.addTransition(start,"a","z",start,[&](MealyMachine*){words++;});
+  mm.addEOFTransition(start);
+  mm.addEOFTransition(digit);
+  REQUIRE_THROWS_AS(mm.save(path),ex::Exception);
+  mm.compile();
+  mm.save(path);
+  REQUIRE(mm.getNofActions() == 2);
+
+  auto loaded = MealyMachine::load(path);
+  REQUIRE(loaded.isCompiled() == true);
+  REQUIRE(loaded.getNofActions() == 2);
+  REQUIRE_NOTHROW(loaded.verify());
+  REQUIRE(loaded.getNofSymbolClasses() == mm.getNofSymbolClasses());
+  //callbacks are not saved
+  REQUIRE(loaded.match("12 ab 3") == true);
+  REQUIRE(digits == 0);
+  size_t loadedDigits = 0;
+  size_t loadedWords  = 0;
+  loaded.bindAction(0,[&](MealyMachine*){loadedDigits++;});
+  loaded.bindAction(1,[&](MealyMachine*){loadedWords++;});
+  REQUIRE_THROWS_AS(loaded.bindAction(2,nullptr),ex::Exception);
+  std::string const input = "12 abc  3 x                             42";
+  REQUIRE(mm    .match(input.c_str()) == true);
+  REQUIRE(loaded.match(input.c_str()) == true);
+  REQUIRE(loadedDigits == digits);
+  REQUIRE(loadedWords  == words );
+  loaded.setQuiet(true);
+  REQUIRE(loaded.match("1a") == false);
+  //cursors share mapped tables
+  auto const before = loadedDigits;
+  auto cursor = loaded.createCursor();
+  REQUIRE(cursor.match("7") == true);
+  REQUIRE(loadedDigits == before+1);
+
+  //token marks and accepting states are saved
+  auto lexer = compileRegex(std::vector<std::string>{"if","[a-z]+","[0-9]+"," +"});
+  lexer.save(path);
+  auto loadedLexer = MealyMachine::load(path);
+  std::vector<MealyMachine::TokenRecord>tokens(16);
+  loadedLexer.setTokenBuffer(tokens.data(),tokens.size());
+  loadedLexer.begin();
+  REQUIRE(loadedLexer.lex("if iff 42") == true);
+  REQUIRE(loadedLexer.endLex() == true);
+  REQUIRE(loadedLexer.getNofTokens() == 5);
+  REQUIRE(tokens[4].kind == 2);
+
+  {
+    std::ofstream file(path,std::ios::binary|std::ios::trunc);
+    file << "this is not Mealy machine, this is text file that is long enough";
+  }
+  REQUIRE_THROWS_AS(MealyMachine::load(path),ex::Exception);
+
+  //cells that point outside of tables are rejected by verify
+  MealyMachine one;
+  auto a = one.addState();
+  one.addTransition(a,"a",a);
+  one.addEOFTransition(a);
+  one.compile();
+  one.save(path);
+  std::string content;
+  {
+    std::ifstream file(path,std::ios::binary);
+    content.assign(std::istreambuf_iterator<char>(file),std::istreambuf_iterator<char>());
+  }
+  //offset of transitions follows magic, version, byte order and 4 counts
+  uint64_t transitions = 0;
+  std::memcpy(&transitions,content.data()+48,sizeof(transitions));
+  uint32_t const state = 1000000;
+  for(size_t c=0;c<one.getNofSymbolClasses();++c)
+    std::memcpy(&content[transitions+c*8],&state,sizeof(state));
+  {
+    std::ofstream file(path,std::ios::binary|std::ios::trunc);
+    file << content;
+  }
+  auto corrupted = MealyMachine::load(path);
+  REQUIRE_THROWS_AS(corrupted.verify(),ex::Exception);
+  std::remove(path.c_str());
+  REQUIRE_THROWS_AS(MealyMachine::load(path),ex::Exception);
+}
+
+constexpr StaticMealyMachineBuilder<5>staticNumberBuilder(){
+  StaticMealyMachineBuilder<5>b;
+  b.addTransition(0,"+-"   ,1  );
+  b.addTransition(0,'0','9',2,0);
+  b.addTransition(1,'0','9',2,0);
+  b.addTransition(2,'0','9',2  );
+  b.addTransition(2,"."    ,3  );
+  b.addTransition(3,'0','9',4,1);
+  b.addTransition(4,'0','9',4  );
+  b.addEOFTransition(2);
+  b.addEOFTransition(4);
+  b.setAccepting(2,0);
+  b.setAccepting(4,1);
+  return b;
+}
+
+constexpr StaticMealyMachine<2,256>staticCommentTable(){
+  StaticMealyMachineBuilder<2>b;
+  b.addTransition(0,"#" ,1);
+  b.addTransition(0,"\n",0);
+  b.addElseTransition(1,1);
+  b.addTransition(1,"\n",0,0);
+  b.addEOFTransition(0);
+  b.addEOFTransition(1);
+  return b.compile();
+}
+
+constexpr auto staticBuilder = staticNumberBuilder();
+static constexpr auto staticNumber  = staticBuilder.compile<staticBuilder.getNofClasses()>();
+static constexpr auto staticComment = staticCommentTable();
+static_assert(staticNumber.getNofClasses() == 4,"symbol classes are computed during compilation");
+static_assert(staticNumber.getNofActions() == 2,"actions are counted during compilation");
+
+SCENARIO("static Mealy machine test"){
+  size_t integers  = 0;
+  size_t fractions = 0;
+  MealyMachine reference;
+  auto s0 = reference.addState();
+  auto s1 = reference.addState();
+  auto s2 = reference.addState();
+  auto s3 = reference.addState();
+  auto s4 = reference.addState();
+  reference.addTransition(s0,"+-"   ,s1);
+  reference.addTransition(s0,"0","9",s2,[&](MealyMachine*){integers++;});
+  reference.addTransition(s1,"0","9",s2,[&](MealyMachine*){integers++;});
+  reference.addTransition(s2,"0","9",s2);
+  reference.addTransition(s2,"."    ,s3);
+  reference.addTransition(s3,"0","9",s4,[&](MealyMachine*){fractions++;});
+  reference.addTransition(s4,"0","9",s4);
+  reference.addEOFTransition(s2);
+  reference.addEOFTransition(s4);
+  reference.setQuiet(true);
+
+  size_t staticIntegers  = 0;
+  size_t staticFractions = 0;
+  auto mm = staticNumber.machine();
+  REQUIRE(mm.isCompiled() == true);
+  REQUIRE(mm.getNofSymbolClasses() == 4);
+  mm.bindAction(0,[&](MealyMachine*){staticIntegers++;});
+  mm.bindAction(1,[&](MealyMachine*){staticFractions++;});
+  mm.setQuiet(true);
+  std::string const alphabet = "+-0123456789.x";
+  Random random(5);
+  for(size_t i=0;i<2000;++i){
+    auto str = random.string(alphabet,random(8));
+    if(random(4) == 0)str += std::string(random(40),'7');
+    REQUIRE(mm.match(str.c_str()) == reference.match(str.c_str()));
+    REQUIRE(staticIntegers  == integers );
+    REQUIRE(staticFractions == fractions);
+  }
+
+  std::vector<MealyMachine::TokenRecord>tokens(4);
+  auto lexer = staticNumber.machine();
+  lexer.setTokenBuffer(tokens.data(),tokens.size());
+  lexer.begin();
+  REQUIRE(lexer.lex("12.512") == true);
+  REQUIRE(lexer.endLex() == true);
+  REQUIRE(lexer.getNofTokens() == 1);
+  REQUIRE(tokens[0].kind == 1);
+
+  size_t comments = 0;
+  auto comment = staticComment.machine();
+  comment.bindAction(0,[&](MealyMachine*){comments++;});
+  REQUIRE(comment.match("#abc\n\n#x y\n#") == true);
+  REQUIRE(comments == 2);
+  //tables can be minimized into runtime storage
+  REQUIRE(staticNumber.machine().minimize().statesAfter == 5);
+}
+
+struct OperatorCounter{
+  size_t counters[5] = {0,0,0,0,0};
+  template<typename Machine>
+  void operator()(uint32_t action,Machine*m){
+    switch(action){
+      case 0:counters[1]++;               break;
+      case 1:counters[0]++;               break;
+      case 2:counters[0]++;m->dontMove(); break;
+      case 3:counters[0]++;               break;
+      case 4:counters[2]++;               break;
+      case 5:counters[2]++;m->dontMove(); break;
+      case 6:counters[2]++;               break;
+      case 7:counters[3]++;               break;
+    }
+  }
+};
+
+SCENARIO("statically dispatched Mealy machine test"){
+  size_t counters[5] = {0,0,0,0,0};
+  auto mm = buildOperatorMachine(countInto(counters));
+  REQUIRE_THROWS_AS(BasicMealyMachine<OperatorCounter>(mm),ex::Exception);
+  mm.compile();
+
+  BasicMealyMachine<OperatorCounter>basic(mm);
+  basic.setQuiet(true);
+  mm.setQuiet(true);
+  Random random(3);
+  for(size_t i=0;i<2000;++i){
+    auto str = random.string("+- x",random(40));
+    if(random(4) == 0)str += std::string(random(40),' ');
+    REQUIRE(basic.match(str.c_str()) == mm.match(str.c_str()));
+    for(size_t c=0;c<5;++c)REQUIRE(basic.getActions().counters[c] == counters[c]);
+  }
+  basic.setQuiet(false);
+  REQUIRE_THROWS_AS(basic.match("+-x"),ex::Exception);
+
+  //static tables with switch dispatch
+  BasicMealyMachine<OperatorCounter>number(staticNumber.machine());
+  REQUIRE(number.match("-12.5") == true);
+  REQUIRE(number.getActions().counters[1] == 1);
+  REQUIRE(number.getActions().counters[0] == 1);
+  //cursor of static tables without MealyMachine
+  BasicMealyMachine<OperatorCounter>view(staticNumber);
+  REQUIRE(view.match("-12.5") == true);
+  REQUIRE(view.getActions().counters[1] == 1);
+  REQUIRE(view.getActions().counters[0] == 1);
+}
+
+SCENARIO("generated scanner test"){
+  MealyMachine mm;
+  auto S = mm.addState();
+  mm.addTransition(S,"a",S);
+  std::stringstream ss;
+  REQUIRE_THROWS_AS(mm.emitCpp(ss),ex::Exception);
+  mm.compile();
+  REQUIRE_THROWS_AS(mm.emitCpp(ss,"1scanner"),ex::Exception);
+  REQUIRE_THROWS_AS(mm.emitCpp(ss,"a-b"),ex::Exception);
+  mm.emitCpp(ss,"AScanner");
+  REQUIRE(ss.str().find("struct AScanner") != std::string::npos);
+
+  //generated from regular expression by mealy-codegen
+  auto number = compileRegex("[+-]?([0-9]+[.]?[0-9]*|[.][0-9]+)([eE][+-]?[0-9]+)?[fF]?");
+  number.setQuiet(true);
+  FloatScanner floatScanner;
+  Random random(7);
+  for(size_t i=0;i<2000;++i){
+    auto str = random.string("0123456789+-.eEfx",random(12));
+    auto const data = reinterpret_cast<uint8_t const*>(str.data());
+    REQUIRE(floatScanner.match(data,str.size()) == number.match(str.c_str()));
+  }
+
+  //generated by MealyMachine::emitCpp with actions
+  auto operators = buildOperatorMachine([](size_t,bool){return MealyMachine::Callback([](MealyMachine*){});});
+  operators.compile();
+  auto counter = OperatorCounter();
+  BasicMealyMachine<OperatorCounter>basic(operators);
+  basic.setQuiet(true);
+  OperatorScanner scanner;
+  for(size_t i=0;i<2000;++i){
+    auto str = random.string("+- x",random(40));
+    auto const data = reinterpret_cast<uint8_t const*>(str.data());
+    REQUIRE(scanner.match(data,str.size(),counter) == basic.match(str.c_str()));
+    REQUIRE(scanner.position == basic.getReadingPosition());
+    for(size_t c=0;c<5;++c)REQUIRE(counter.counters[c] == basic.getActions().counters[c]);
+  }
+
+  //the scanner continues in the next part of input
+  counter = OperatorCounter();
+  basic.getActions() = OperatorCounter();
+  std::string const str = "+-- ++-+ -";
+  auto const data = reinterpret_cast<uint8_t const*>(str.data());
+  scanner.begin();
+  REQUIRE(scanner.parse(data  ,3           ,counter) == true);
+  REQUIRE(scanner.parse(data+3,str.size()-3,counter) == true);
+  REQUIRE(scanner.end(counter) == true);
+  REQUIRE(scanner.position == str.size());
+  REQUIRE(basic.match(str.c_str()) == true);
+  for(size_t c=0;c<5;++c)REQUIRE(counter.counters[c] == basic.getActions().counters[c]);
+}
+
+SCENARIO("action program test"){
+  using M = MealyMachine;
+  size_t counters[5] = {0,0,0,0,0};
+  auto callbacks = buildOperatorMachine(countInto(counters));
+  auto inc = [](size_t i,bool dontMove){
+    if(dontMove)return M::program({M::inc(static_cast<uint32_t>(i)),M::noMove()});
+    return M::program({M::inc(static_cast<uint32_t>(i))});
+  };
+  auto programs = buildOperatorMachine(inc);
+  auto compiled = buildOperatorMachine(inc);
+  REQUIRE(programs.getNofActions() == 8);
+  compiled.compile();
+  auto deferred = compiled.createCursor();
+  deferred.setDeferred(true);
+  callbacks.setQuiet(true);
+  programs .setQuiet(true);
+  compiled .setQuiet(true);
+  deferred.setQuiet(true);
+  Random random(11);
+  for(size_t i=0;i<1000;++i){
+    auto str = random.string("+- x",random(40));
+    if(random(4) == 0)str += std::string(random(40),' ');
+    auto const result = callbacks.match(str.c_str());
+    REQUIRE(programs .match(str.c_str()) == result);
+    REQUIRE(compiled .match(str.c_str()) == result);
+    REQUIRE(deferred.match(str.c_str()) == result);
+    for(size_t c=0;c<5;++c){
+      REQUIRE(programs .getSlot(c) == counters[c]);
+      REQUIRE(compiled .getSlot(c) == counters[c]);
+      REQUIRE(deferred.getSlot(c) == counters[c]);
+    }
+  }
+  programs.clearSlots();
+  REQUIRE(programs.getSlot(0) == 0);
+
+  //marks, tokens and callbacks in one action
+  size_t words = 0;
+  std::vector<M::TokenRecord>tokens(16);
+  MealyMachine mm;
+  auto start = mm.addState();
+  auto word  = mm.addState();
+  mm.addTransition   (start,"a","z",word ,M::token(M::TOKEN_BEGIN,0,M::program({M::mark(0)},[&](MealyMachine*){words++;})));
+  mm.addTransition   (word ,"a","z",word );
+  mm.addTransition   (word ," "    ,start,M::program({M::emit(5),M::mark(1)}));
+  mm.addTransition   (start," "    ,start);
+  mm.addEOFTransition(start);
+  mm.addEOFTransition(word        ,M::program({M::emit(5),M::mark(1)}));
+  mm.setTokenBuffer(tokens.data(),tokens.size());
+  REQUIRE(mm.match("ab  cde") == true);
+  REQUIRE(words == 2);
+  REQUIRE(mm.getNofTokens() == 2);
+  REQUIRE(tokens[0].begin == 0);
+  REQUIRE(tokens[0].end   == 2);
+  REQUIRE(tokens[1].begin == 4);
+  REQUIRE(tokens[1].end   == 7);
+  REQUIRE(tokens[1].kind  == 5);
+  REQUIRE(mm.getSlot(0) == 4);
+  REQUIRE(mm.getSlot(1) == 7);
+
+  //programs are saved
+  std::string const path = "mealyMachineProgramTest.bin";
+  mm.compile();
+  mm.save(path);
+  auto loaded = MealyMachine::load(path);
+  loaded.setTokenBuffer(tokens.data(),tokens.size());
+  REQUIRE(loaded.match("xy z") == true);
+  REQUIRE(loaded.getNofTokens() == 2);
+  REQUIRE(tokens[1].begin == 3);
+  REQUIRE(tokens[1].end   == 4);
+  REQUIRE(loaded.getSlot(0) == 3);
+  REQUIRE(words == 2);
+  std::remove(path.c_str());
+}
+
+SCENARIO("non-consuming transition test"){
+  using M = MealyMachine;
+  size_t counters[5] = {0,0,0,0,0};
+  auto count = countInto(counters);
+  auto inc = [](size_t i,bool dontMove){
+    auto const program = M::program({M::inc(static_cast<uint32_t>(i))});
+    return dontMove?M::nonConsuming(program):program;
+  };
+  auto callbacks = buildOperatorMachine(count);
+  auto programs  = buildOperatorMachine(inc);
+  auto compiled  = buildOperatorMachine(inc);
+  compiled.compile();
+  //else transitions are merged with transitions of S
+  REQUIRE(compiled.getNofActions() > programs.getNofActions());
+  callbacks.setQuiet(true);
+  programs .setQuiet(true);
+  compiled .setQuiet(true);
+  Random random(13);
+  for(size_t i=0;i<1000;++i){
+    auto str = random.string("+- x",random(40));
+    auto const result = callbacks.match(str.c_str());
+    REQUIRE(programs.match(str.c_str()) == result);
+    REQUIRE(compiled.match(str.c_str()) == result);
+    REQUIRE(compiled.getReadingPosition() == callbacks.getReadingPosition());
+    for(size_t c=0;c<5;++c){
+      REQUIRE(programs.getSlot(c) == counters[c]);
+      REQUIRE(compiled.getSlot(c) == counters[c]);
+    }
+  }
+
+  //collapsed cells are plain cells, so cursors that ignore programs see them
+  MealyMachine mm;
+  auto S = mm.addState();
+  auto P = mm.addState();
+  mm.addTransition    (S,"+",P);
+  mm.addTransition    (S," ",S);
+  mm.addEOFTransition (S);
+  mm.addTransition    (P,"+",S,count(1,false));
+  mm.addElseTransition(P,S    ,M::nonConsuming());
+  mm.addEOFTransition (P);
+  mm.compile();
+  BasicMealyMachine<OperatorCounter>basic(mm);
+  REQUIRE(basic.match("+ ++ + +++") == true);
+  REQUIRE(basic.getActions().counters[1] == 2);
+  basic.setQuiet(true);
+  REQUIRE(basic.match("+x") == false);
+  REQUIRE(basic.getCurrentState() == P);
+
+  //noMove that is not collapsed cannot be ignored
+  MealyMachine kept;
+  auto K = kept.addState();
+  kept.addTransition    (K,"+",K);
+  kept.addElseTransition(K,K,M::nonConsuming(count(0,false)));
+  kept.compile();
+  REQUIRE_THROWS_AS(BasicMealyMachine<OperatorCounter>(kept),ex::Exception);
+  std::stringstream ss;
+  REQUIRE_THROWS_AS(kept.emitCpp(ss),ex::Exception);
+
+  //cycles of non-consuming transitions are not collapsed
+  MealyMachine cycle;
+  auto A = cycle.addState();
+  auto B = cycle.addState();
+  for(size_t i=0;i<3000;++i)cycle.addState();
+  cycle.addElseTransition(A,B,M::nonConsuming(M::program({M::inc(0)})));
+  cycle.addElseTransition(B,A,M::nonConsuming(M::program({M::inc(1)})));
+  cycle.compile();
+  REQUIRE(cycle.isCompiled() == true);
+  REQUIRE(cycle.getNofActions() == 2);
+  REQUIRE(cycle.getNofSymbolClasses() == 1);
+  std::string const path = "mealyMachineCycleTest.bin";
+  cycle.save(path);
+  std::string content;
+  {
+    std::ifstream file(path,std::ios::binary);
+    content.assign(std::istreambuf_iterator<char>(file),std::istreambuf_iterator<char>());
+  }
+  std::remove(path.c_str());
+  //offset of transitions follows magic, version, byte order and 4 counts
+  uint64_t transitions = 0;
+  std::memcpy(&transitions,content.data()+48,sizeof(transitions));
+  uint32_t cells[4] = {};
+  std::memcpy(cells,content.data()+transitions,sizeof(cells));
+  REQUIRE(cells[0] == B);
+  REQUIRE(cells[1] == 0);
+  REQUIRE(cells[2] == A);
+  REQUIRE(cells[3] == 1);
+}